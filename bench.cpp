@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "types.hpp"
+#include "board.hpp"
+#include "solver.hpp"
+#include "device.hpp"
+#include "to_board.hpp"
+#include "workload.hpp"
+#include "host_solver.hpp"
+
+// Micro benchmarks of the board primitives and macro benchmarks of the CPU
+// backend's solve and the host solver on fixed, seeded position sets. Output is one tab
+// separated line per benchmark:
+//   name  group  ops  ns/op median  min  max  nodes/s (median run, or -)
+
+namespace {
+
+struct Options {
+  int reps = 5;
+  int positions = 64;       // per empty count for the solve benchmarks
+  int min_empties = 8;
+  int max_empties = 12;
+  std::string filter;
+};
+
+struct Measure {
+  std::size_t ops;
+  ull nodes; // 0 if the benchmark does not count nodes
+};
+
+volatile ull sink;
+
+bool starts_with(const std::string &str, const std::string &prefix) {
+  return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+// one warmup run, then opt.reps timed runs
+void run(const Options &opt, const std::string &name, const std::string &group,
+    const std::function<Measure()> &body) {
+  if (!opt.filter.empty() && name.find(opt.filter) == std::string::npos) return;
+  body();
+  std::vector<double> ns_per_op;
+  Measure m = {0, 0};
+  for (int i = 0; i < opt.reps; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    m = body();
+    const auto end = std::chrono::steady_clock::now();
+    ns_per_op.push_back(std::chrono::duration<double, std::nano>(end - start).count() / m.ops);
+  }
+  std::vector<double> sorted = ns_per_op;
+  std::sort(sorted.begin(), sorted.end());
+  const double median = sorted[sorted.size() / 2];
+  std::printf("%s\t%s\t%zu\t%.3f\t%.3f\t%.3f\t", name.c_str(), group.c_str(), m.ops,
+      median, sorted.front(), sorted.back());
+  if (m.nodes) {
+    std::printf("%.4g\n", m.nodes / (median * m.ops * 1e-9));
+  } else {
+    std::printf("-\n");
+  }
+  std::fflush(stdout);
+}
+
+std::vector<Board> positions(int empties, int count, ull seed) {
+  return random_positions(seed, count, empties, empties);
+}
+
+void bench_board(const Options &opt) {
+  std::vector<Board> boards;
+  for (int empties = 10; empties <= 50; empties += 4) {
+    const std::vector<Board> set = positions(empties, 256, empties);
+    boards.insert(boards.end(), set.begin(), set.end());
+  }
+  struct Move { ull me, op; int pos; };
+  std::vector<Move> moves;
+  for (const Board &bd : boards) {
+    for (ull bits = mobility(bd.me, bd.op); bits; bits &= bits - 1) {
+      moves.push_back((Move){bd.me, bd.op, __builtin_ctzll(bits)});
+    }
+  }
+  constexpr int loops = 64;
+  run(opt, "popcnt", "mixed", [&] {
+    ull sum = 0;
+    for (int l = 0; l < loops; ++l) for (const Board &bd : boards) sum += popcnt(bd.me ^ l);
+    sink = sum;
+    return (Measure){loops * boards.size(), 0};
+  });
+  run(opt, "flip", "mixed", [&] {
+    ull sum = 0;
+    for (int l = 0; l < loops; ++l) for (const Move &m : moves) sum += flip(m.me, m.op, m.pos);
+    sink = sum;
+    return (Measure){loops * moves.size(), 0};
+  });
+  run(opt, "mobility", "mixed", [&] {
+    ull sum = 0;
+    for (int l = 0; l < loops; ++l) for (const Board &bd : boards) sum += mobility(bd.me, bd.op ^ l);
+    sink = sum;
+    return (Measure){loops * boards.size(), 0};
+  });
+  run(opt, "mobility_count", "mixed", [&] {
+    ull sum = 0;
+    for (int l = 0; l < loops; ++l) for (const Board &bd : boards) sum += mobility_count(bd.me, bd.op ^ l);
+    sink = sum;
+    return (Measure){loops * boards.size(), 0};
+  });
+  run(opt, "stable_count", "mixed", [&] {
+    ull sum = 0;
+    for (const Board &bd : boards) sum += stable_count(bd.me, bd.op);
+    sink = sum;
+    return (Measure){boards.size(), 0};
+  });
+  run(opt, "upper_node", "mixed", [&] {
+    ull sum = 0;
+    for (const Board &bd : boards) {
+      UpperNode node(bd.me, bd.op, -64, 64);
+      sum += node.pop();
+    }
+    sink = sum;
+    return (Measure){boards.size(), 0};
+  });
+
+  std::vector<char> text(boards.size() * 16);
+  fromBoardBatch(boards.data(), text.data(), boards.size());
+  std::vector<Board> decoded(boards.size(), Board(0, 0));
+  run(opt, "toBoard", "mixed", [&] {
+    ull sum = 0;
+    for (int l = 0; l < loops; ++l) {
+      for (std::size_t i = 0; i < boards.size(); ++i) sum += toBoard(text.data() + i*16).me;
+    }
+    sink = sum;
+    return (Measure){loops * boards.size(), 0};
+  });
+  run(opt, std::string("toBoardBatch.") + board_codec_name(), "mixed", [&] {
+    for (int l = 0; l < loops; ++l) toBoardBatch(text.data(), decoded.data(), boards.size());
+    sink = decoded.back().me;
+    return (Measure){loops * boards.size(), 0};
+  });
+  run(opt, std::string("fromBoardBatch.") + board_codec_name(), "mixed", [&] {
+    for (int l = 0; l < loops; ++l) fromBoardBatch(boards.data(), text.data(), boards.size());
+    sink = text.back();
+    return (Measure){loops * boards.size(), 0};
+  });
+}
+
+void bench_solve(const Options &opt) {
+  for (int empties = opt.min_empties; empties <= opt.max_empties; ++empties) {
+    std::vector<AlphaBetaProblem> problems;
+    for (const Board &bd : positions(empties, opt.positions, 1000 + empties)) {
+      problems.push_back(AlphaBetaProblem(bd.me, bd.op));
+    }
+    std::vector<AlphaBetaResult> results(problems.size());
+    // no table, so that every run visits the same nodes
+    const std::size_t upper = std::max(1, empties - 8);
+    const SolverConfig config = {upper, lower_stack_size_for(empties, upper), 0, 0, 0, 0, 0, 0, nullptr};
+    std::unique_ptr<Device> device = open_cpu_device(1, config);
+    run(opt, "solve", "empties=" + std::to_string(empties), [&] {
+      device->solve(problems.data(), results.data(), problems.size());
+      ull nodes = 0;
+      for (const AlphaBetaResult &res : results) nodes += res.nodes;
+      return (Measure){problems.size(), nodes};
+    });
+    run(opt, "host_solve", "empties=" + std::to_string(empties), [&] {
+      ull nodes = 0;
+      for (const AlphaBetaProblem &problem : problems) {
+        HostSolver solver;
+        sink = solver.solve(problem.me, problem.op);
+        nodes += solver.nodes;
+      }
+      return (Measure){problems.size(), nodes};
+    });
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (starts_with(arg, "--reps=")) {
+      opt.reps = std::max(1, std::stoi(arg.substr(7)));
+    } else if (starts_with(arg, "--positions=")) {
+      opt.positions = std::max(1, std::stoi(arg.substr(12)));
+    } else if (starts_with(arg, "--empties=")) {
+      const std::string range = arg.substr(10);
+      const std::size_t dash = range.find('-');
+      opt.min_empties = std::stoi(range.substr(0, dash));
+      opt.max_empties = dash == std::string::npos ? opt.min_empties : std::stoi(range.substr(dash + 1));
+    } else if (starts_with(arg, "--filter=")) {
+      opt.filter = arg.substr(9);
+    } else {
+      std::cerr << "usage: " << argv[0] << " [--reps=N] [--positions=N] [--empties=LO-HI] [--filter=NAME]" << std::endl;
+      return 1;
+    }
+  }
+  std::printf("# name\tgroup\tops\tns/op\tmin\tmax\tnodes/s\n");
+  bench_board(opt);
+  bench_solve(opt);
+  return 0;
+}
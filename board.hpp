@@ -1,7 +1,18 @@
 #pragma once
 #include "types.hpp"
 
+#ifdef __POPCNT__
+// host builds (-march=native): the instruction, inlined into the searches
+inline int popcnt(ull player) {
+  return __builtin_popcountll(player);
+}
+inline int stones_count(ull player, ull opponent) {
+  return __builtin_popcountll(player | opponent);
+}
+#else
 int popcnt(ull player);
+int stones_count(ull player, ull opponent);
+#endif
 ull flip(ull player, ull opponent, int pos);
 ull mobility(ull player, ull opponent);
 int mobility_count(ull player, ull opponent);
@@ -12,4 +23,5 @@ inline int final_score(ull player, ull opponent) {
   if (pcnt > ocnt) return 64 - 2*ocnt;
   return 2*pcnt - 64;
 }
-int stones_count(ull player, ull opponent);
+// number of player's discs that can no longer be flipped (a lower estimate)
+int stable_count(ull player, ull opponent);
@@ -0,0 +1,40 @@
+#include <iostream>
+#include <string>
+#include "problem_file.hpp"
+
+// Converts between the base-81 text format and the binary problem/result files.
+//   convert to-binary INPUT OUTPUT.bin       text or binary problems -> binary problems
+//   convert to-text INPUT OUTPUT.txt         text or binary problems -> text problems
+//   convert results PROBLEMS RESULTS.bin OUTPUT.txt
+//                                            binary results -> "board score nodes" lines
+
+void usage(const char *prog) {
+  std::cerr << "usage: " << prog << " to-binary INPUT OUTPUT" << std::endl;
+  std::cerr << "       " << prog << " to-text INPUT OUTPUT" << std::endl;
+  std::cerr << "       " << prog << " results PROBLEMS RESULTS OUTPUT" << std::endl;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 4) {
+    usage(argv[0]);
+    return 1;
+  }
+  const std::string command = argv[1];
+  ProblemSet problems;
+  if (!problems.load(argv[2])) return 1;
+  if (command == "to-binary" && argc == 4) {
+    return write_problems_binary(argv[3], problems.data(), problems.size()) ? 0 : 1;
+  } else if (command == "to-text" && argc == 4) {
+    return write_problems_text(argv[3], problems.data(), problems.size()) ? 0 : 1;
+  } else if (command == "results" && argc == 5) {
+    ResultSet results;
+    if (!results.load(argv[3])) return 1;
+    if (results.size() != problems.size()) {
+      std::cerr << "problem count " << problems.size() << " != result count " << results.size() << std::endl;
+      return 1;
+    }
+    return write_results_text(argv[4], problems.data(), results.data(), nullptr, nullptr, results.size()) ? 0 : 1;
+  }
+  usage(argv[0]);
+  return 1;
+}
@@ -0,0 +1,135 @@
+// Host implementation of board.hpp, shared by the CPU backend and the host
+// verification search. Like all host code it is built with -march=native,
+// so the variant is picked at compile time: on CPUs with AVX2 the four
+// directions that flip_impl/mobility_impl evaluate one after another run
+// as the four 64-bit lanes of one vector (with AVX-512VL/CD, flip takes
+// upper_bit from vplzcntq), otherwise pzc/board.pzc is used as it is.
+// popcnt and stones_count are inline in board.hpp.
+#include <x86intrin.h>
+#include "pzc_builtin.h"
+#include "../board.hpp"
+
+namespace generic {
+#include "../pzc/board.pzc"
+} // namespace generic
+
+namespace {
+
+constexpr ull not_a_file = UINT64_C(0x7E7E7E7E7E7E7E7E);
+
+#ifdef __AVX2__
+
+ull or_lanes(__m256i x) {
+  const __m128i y = _mm_or_si128(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+  return _mm_cvtsi128_si64(y) | _mm_extract_epi64(y, 1);
+}
+
+// Lanes are simd_index 0..3 of generic::flip_impl. The AVX-512 variant
+// differs only in taking upper_bit from lzcnt; the rest is inlined into both.
+struct FlipLanes {
+  __m256i p, om, mask1;
+};
+
+inline FlipLanes flip_lanes(ull player, ull opponent, int pos) {
+  return (FlipLanes){
+    _mm256_set1_epi64x(player),
+    _mm256_and_si256(_mm256_set1_epi64x(opponent),
+        _mm256_setr_epi64x(-1, not_a_file, not_a_file, not_a_file)),
+    _mm256_srl_epi64(_mm256_setr_epi64x(
+        UINT64_C(0x0080808080808080), UINT64_C(0x7F00000000000000),
+        UINT64_C(0x0102040810204000), UINT64_C(0x0040201008040201)), _mm_cvtsi32_si128(63 - pos))
+  };
+}
+
+// upper = upper_bit(~om & mask1)
+inline ull flip_finish(const FlipLanes &lanes, __m256i upper, int pos) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i outflank = _mm256_and_si256(upper, lanes.p);
+  __m256i flipped = _mm256_and_si256(_mm256_slli_epi64(_mm256_sub_epi64(zero, outflank), 1), lanes.mask1);
+  const __m256i mask2 = _mm256_sll_epi64(_mm256_setr_epi64x(
+      UINT64_C(0x0101010101010100), UINT64_C(0x00000000000000FE),
+      UINT64_C(0x0002040810204080), UINT64_C(0x8040201008040200)), _mm_cvtsi32_si128(pos));
+  // (om | ~mask2) + 1 == -(mask2 & ~om)
+  outflank = _mm256_and_si256(_mm256_and_si256(mask2, lanes.p),
+      _mm256_sub_epi64(zero, _mm256_andnot_si256(lanes.om, mask2)));
+  const __m256i inner = _mm256_andnot_si256(_mm256_cmpeq_epi64(outflank, zero),
+      _mm256_add_epi64(outflank, _mm256_set1_epi64x(-1)));
+  flipped = _mm256_or_si256(flipped, _mm256_and_si256(inner, mask2));
+  return or_lanes(flipped);
+}
+
+#if !(defined(__AVX512VL__) && defined(__AVX512CD__))
+ull flip_avx2(ull player, ull opponent, int pos) {
+  const FlipLanes lanes = flip_lanes(player, opponent, pos);
+  __m256i x = _mm256_andnot_si256(lanes.om, lanes.mask1);
+  x = _mm256_or_si256(x, _mm256_srli_epi64(x, 1));
+  x = _mm256_or_si256(x, _mm256_srli_epi64(x, 2));
+  x = _mm256_or_si256(x, _mm256_srli_epi64(x, 4));
+  x = _mm256_or_si256(x, _mm256_srli_epi64(x, 8));
+  x = _mm256_or_si256(x, _mm256_srli_epi64(x, 16));
+  x = _mm256_or_si256(x, _mm256_srli_epi64(x, 32));
+  x = _mm256_andnot_si256(_mm256_srli_epi64(x, 1), x);
+  return flip_finish(lanes, x, pos);
+}
+#endif
+
+#if defined(__AVX512VL__) && defined(__AVX512CD__)
+ull flip_avx512(ull player, ull opponent, int pos) {
+  const FlipLanes lanes = flip_lanes(player, opponent, pos);
+  const __m256i x = _mm256_andnot_si256(lanes.om, lanes.mask1);
+  // a shift count of 64 (lzcnt of 0) yields 0
+  const __m256i upper = _mm256_srlv_epi64(_mm256_set1_epi64x(INT64_MIN), _mm256_lzcnt_epi64(x));
+  return flip_finish(lanes, upper, pos);
+}
+#endif
+
+// lanes are simd_index 0..3 of generic::mobility_impl
+ull mobility_avx2(ull player, ull opponent) {
+  const __m256i shift1 = _mm256_setr_epi64x(1, 7, 9, 8);
+  const __m256i shift2 = _mm256_add_epi64(shift1, shift1);
+  const __m256i pp = _mm256_set1_epi64x(player);
+  const __m256i moo = _mm256_and_si256(_mm256_set1_epi64x(opponent),
+      _mm256_setr_epi64x(not_a_file, not_a_file, not_a_file, -1));
+  __m256i flip_l = _mm256_and_si256(moo, _mm256_sllv_epi64(pp, shift1));
+  __m256i flip_r = _mm256_and_si256(moo, _mm256_srlv_epi64(pp, shift1));
+  flip_l = _mm256_or_si256(flip_l, _mm256_and_si256(moo, _mm256_sllv_epi64(flip_l, shift1)));
+  flip_r = _mm256_or_si256(flip_r, _mm256_and_si256(moo, _mm256_srlv_epi64(flip_r, shift1)));
+  const __m256i pre_l = _mm256_and_si256(moo, _mm256_sllv_epi64(moo, shift1));
+  const __m256i pre_r = _mm256_srlv_epi64(pre_l, shift1);
+  flip_l = _mm256_or_si256(flip_l, _mm256_and_si256(pre_l, _mm256_sllv_epi64(flip_l, shift2)));
+  flip_r = _mm256_or_si256(flip_r, _mm256_and_si256(pre_r, _mm256_srlv_epi64(flip_r, shift2)));
+  flip_l = _mm256_or_si256(flip_l, _mm256_and_si256(pre_l, _mm256_sllv_epi64(flip_l, shift2)));
+  flip_r = _mm256_or_si256(flip_r, _mm256_and_si256(pre_r, _mm256_srlv_epi64(flip_r, shift2)));
+  const __m256i mm = _mm256_or_si256(_mm256_sllv_epi64(flip_l, shift1), _mm256_srlv_epi64(flip_r, shift1));
+  return or_lanes(mm) & ~(player | opponent);
+}
+
+#endif // __AVX2__
+
+} // namespace
+
+ull flip(ull player, ull opponent, int pos) {
+#if defined(__AVX512VL__) && defined(__AVX512CD__)
+  return flip_avx512(player, opponent, pos);
+#elif defined(__AVX2__)
+  return flip_avx2(player, opponent, pos);
+#else
+  return generic::flip(player, opponent, pos);
+#endif
+}
+
+ull mobility(ull player, ull opponent) {
+#ifdef __AVX2__
+  return mobility_avx2(player, opponent);
+#else
+  return generic::mobility(player, opponent);
+#endif
+}
+
+int mobility_count(ull player, ull opponent) {
+  return popcnt(mobility(player, opponent));
+}
+
+int stable_count(ull player, ull opponent) {
+  return popcnt(generic::stable_discs(player, opponent));
+}
@@ -0,0 +1,18 @@
+#pragma once
+// Host stand-ins for the PZC builtins used in pzc/*.pzc.
+// Each CPU worker thread plays the role of one PE thread.
+
+#include <cstddef>
+
+struct PzcThread {
+  int tid;
+  int maxtid;
+};
+
+extern thread_local PzcThread pzc_thread;
+
+inline int get_tid() { return pzc_thread.tid; }
+inline int get_pid() { return 0; }
+inline int get_maxtid() { return pzc_thread.maxtid; }
+inline int get_maxpid() { return 1; }
+inline void flush() {}
@@ -0,0 +1 @@
+#include "../pzc/solver.pzc"
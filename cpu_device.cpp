@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "device.hpp"
+#include "cpu/pzc_builtin.h"
+
+thread_local PzcThread pzc_thread = {0, 1};
+
+void pzc_Solve(
+    const AlphaBetaProblem * const abp, AlphaBetaResult * const result,
+    UpperNode * const upper_stack, Node * const lower_stack,
+    const size_t count, const size_t upper_stack_size,
+    const size_t lower_stack_size, TableEntry * const table_entries,
+    const size_t table_size, ThreadStats * const stats,
+    size_t * const counter, const size_t fastest_first_empties,
+    const size_t node_budget, const size_t ordering_mode,
+    const size_t ordering_empties, const short * const pattern_weights);
+
+namespace {
+
+class CpuDevice : public Device {
+ public:
+  CpuDevice(int num_threads, const SolverConfig &config)
+    : num_threads(num_threads), config(config),
+      upper_stack(num_threads * config.upper_stack_size),
+      lower_stack(num_threads * config.lower_stack_size),
+      table(config.table_size), stats(num_threads), total_stats(num_threads), counter(0) {}
+  std::string name() const override {
+    return "cpu(" + std::to_string(num_threads) + " threads)";
+  }
+  std::size_t min_batch_size() const override {
+    return num_threads * 16;
+  }
+  void solve(const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count) override {
+    counter = 0;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back([=] {
+        pzc_thread = (PzcThread){i, num_threads};
+        pzc_Solve(problems, results, upper_stack.data(), lower_stack.data(),
+            count, config.upper_stack_size, config.lower_stack_size,
+            table.data(), table.size(), stats.data(), &counter,
+            config.fastest_first_empties, config.node_budget,
+            config.ordering, config.ordering_empties, config.pattern_weights);
+      });
+    }
+    for (auto &thread : threads) thread.join();
+    for (int i = 0; i < num_threads; ++i) {
+      total_stats[i].nodes_total += stats[i].nodes_total;
+      total_stats[i].table_hits += stats[i].table_hits;
+      total_stats[i].table_misses += stats[i].table_misses;
+    }
+  }
+  std::vector<ThreadStats> thread_stats() const override {
+    return total_stats;
+  }
+ private:
+  int num_threads;
+  SolverConfig config;
+  std::vector<UpperNode> upper_stack;
+  std::vector<Node> lower_stack;
+  std::vector<TableEntry> table;
+  std::vector<ThreadStats> stats;
+  std::vector<ThreadStats> total_stats;
+  size_t counter;
+};
+
+} // namespace
+
+std::size_t table_entries_for(std::size_t megabytes) {
+  const std::size_t limit = megabytes * 1024 * 1024 / sizeof(TableEntry);
+  std::size_t entries = 1;
+  while (entries * 2 <= limit) entries *= 2;
+  return limit ? entries : 0;
+}
+
+std::unique_ptr<Device> open_cpu_device(int num_threads, const SolverConfig &config) {
+  if (num_threads <= 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+  return std::unique_ptr<Device>(new CpuDevice(num_threads, config));
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "solver.hpp"
+
+struct DeviceUsage {
+  double seconds;
+  std::size_t problems;
+  std::size_t batches;
+};
+
+struct SolverConfig {
+  std::size_t upper_stack_size;
+  std::size_t lower_stack_size;
+  std::size_t table_size; // entries per device, a power of two or 0
+  std::size_t fastest_first_empties; // lower nodes ordered fastest first from here, 0: never
+  std::size_t work_items; // threads per PZCL kernel launch, 0: default
+  std::size_t node_budget; // nodes per problem before it is suspended, 0: unlimited
+  std::size_t ordering; // upper node ordering_* bits, 0: by mobility
+  std::size_t ordering_empties; // upper nodes ordered by ordering from here
+  const short *pattern_weights; // pattern_weight_count weights, or null
+};
+
+// Lower frames needed below upper_stack_size upper frames to search
+// positions with up to max_empties empties: one frame per ply until
+// solve_last takes over (passes reuse the frame).
+inline std::size_t lower_stack_size_for(int max_empties, std::size_t upper_stack_size) {
+  const long frames = (long)max_empties - last_empties - (long)upper_stack_size;
+  return frames > 1 ? frames : 1;
+}
+
+// Default upper frames for positions with up to max_empties empties: all
+// plies but the last one above solve_last are ordered and go through the
+// table (fastest overall on 16 to 20 empties).
+inline std::size_t upper_stack_size_for(int max_empties) {
+  const long frames = (long)max_empties - last_empties - 1;
+  return frames > 1 ? frames : 1;
+}
+
+inline std::size_t stack_bytes_per_thread(const SolverConfig &config) {
+  return config.upper_stack_size * sizeof(UpperNode) + config.lower_stack_size * sizeof(Node);
+}
+
+class Device {
+ public:
+  Device() : device_usage{0.0, 0, 0} {}
+  virtual ~Device() {}
+  virtual std::string name() const = 0;
+  // smallest batch that keeps every thread of the device busy
+  virtual std::size_t min_batch_size() const = 0;
+  // solve problems[0, count) and write their results to results[0, count)
+  virtual void solve(const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count) = 0;
+  // Asynchronous solve: starts problems[0, count) and may return before the
+  // results are written. Both arrays must stay untouched until the finish()
+  // that completes the batch. Batches complete in submission order and at
+  // most pipeline_depth() are in flight; devices without their own transfer
+  // queue solve in submit().
+  virtual void submit(const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count) {
+    solve(problems, results, count);
+  }
+  // waits for the oldest batch in flight
+  virtual void finish() {}
+  virtual std::size_t pipeline_depth() const {
+    return 1;
+  }
+  // per-thread statistics accumulated over all solve calls
+  virtual std::vector<ThreadStats> thread_stats() const = 0;
+  const DeviceUsage &usage() const {
+    return device_usage;
+  }
+  void add_usage(double seconds, std::size_t problems) {
+    device_usage.seconds += seconds;
+    device_usage.problems += problems;
+    ++device_usage.batches;
+  }
+ private:
+  DeviceUsage device_usage;
+};
+
+// largest power of two number of table entries that fits in megabytes
+std::size_t table_entries_for(std::size_t megabytes);
+
+std::unique_ptr<Device> open_cpu_device(int num_threads, const SolverConfig &config);
+// HostSolver on OpenMP threads instead of the kernel's Solver
+std::unique_ptr<Device> open_host_device(int num_threads);
+std::vector<std::unique_ptr<Device>> open_pzcl_devices(const char *binary_path, const SolverConfig &config);
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include "dispatch.hpp"
+#include "board.hpp"
+
+int estimate_cost(const AlphaBetaProblem &problem) {
+  const int empties = 64 - stones_count(problem.me, problem.op);
+  return empties * 64 + mobility_count(problem.me, problem.op);
+}
+
+namespace {
+
+// Hands out batches to workers (devices) by guided self-scheduling,
+// weighted by throughput: once every worker has a measured rate, a worker
+// gets a share of the remaining problems proportional to its problems per
+// second, so a slow card or the host pool takes smaller batches and the
+// workers tend to finish together.
+class BatchQueue {
+ public:
+  BatchQueue(std::size_t count, const std::vector<std::unique_ptr<Device>> &devices, std::size_t max_batch_size)
+    : count(count), max_batch_size(max_batch_size), next(0), rates(devices.size()) {
+    for (std::size_t i = 0; i < devices.size(); ++i) {
+      const DeviceUsage &usage = devices[i]->usage();
+      if (usage.seconds > 0) rates[i] = usage.problems / usage.seconds;
+    }
+  }
+  // returns false when the queue is drained
+  bool pop(std::size_t worker, std::size_t min_batch_size, std::size_t &first, std::size_t &size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (next >= count) return false;
+    const std::size_t remaining = count - next;
+    // large batches first, shrinking toward the tail
+    size = std::max(min_batch_size, (std::size_t)(remaining * share(worker) / 2));
+    if (max_batch_size) size = std::min(size, max_batch_size);
+    size = std::min(std::max<std::size_t>(size, 1), remaining);
+    first = next;
+    next += size;
+    return true;
+  }
+  // records that worker solved problems in seconds
+  void report(std::size_t worker, double seconds, std::size_t problems) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (seconds <= 0) return;
+    const double rate = problems / seconds;
+    rates[worker] = rates[worker] > 0 ? (rates[worker] + rate) / 2 : rate;
+  }
+ private:
+  // worker's fraction of the total rate, an equal split until all are known
+  double share(std::size_t worker) const {
+    double total = 0;
+    for (double rate : rates) {
+      if (rate <= 0) return 1.0 / rates.size();
+      total += rate;
+    }
+    return rates[worker] / total;
+  }
+  std::mutex mutex;
+  std::size_t count;
+  std::size_t max_batch_size;
+  std::size_t next;
+  std::vector<double> rates; // problems per second, averaged over batches
+};
+
+void solve_unsorted(const std::vector<std::unique_ptr<Device>> &devices,
+    const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count,
+    const DispatchOptions &options) {
+  BatchQueue queue(count, devices, options.max_batch_size);
+  std::vector<std::thread> workers;
+  for (std::size_t worker = 0; worker < devices.size(); ++worker) {
+    Device *device = devices[worker].get();
+    workers.emplace_back([=, &queue] {
+      std::size_t first, size;
+      while (queue.pop(worker, device->min_batch_size(), first, size)) {
+        const auto start = std::chrono::steady_clock::now();
+        device->solve(problems + first, results + first, size);
+        const auto end = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        device->add_usage(seconds, size);
+        queue.report(worker, seconds, size);
+      }
+    });
+  }
+  for (auto &worker : workers) worker.join();
+}
+
+} // namespace
+
+void escalate(Device &device, const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count) {
+  std::vector<AlphaBetaProblem> retry;
+  std::vector<std::size_t> index;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (!results[i].suspended) continue;
+    // scores are even, so the answer lies strictly inside the narrowed window
+    const AlphaBetaProblem &problem = problems[i];
+    retry.push_back(AlphaBetaProblem(problem.me, problem.op,
+        std::max(problem.alpha, results[i].score - 1), std::min(problem.beta, results[i].upper + 1)));
+    index.push_back(i);
+  }
+  if (retry.empty()) return;
+  std::vector<AlphaBetaResult> retry_results(retry.size());
+  const auto start = std::chrono::steady_clock::now();
+  device.solve(retry.data(), retry_results.data(), retry.size());
+  const auto end = std::chrono::steady_clock::now();
+  device.add_usage(std::chrono::duration<double>(end - start).count(), retry.size());
+  for (std::size_t k = 0; k < retry.size(); ++k) {
+    const ull nodes = results[index[k]].nodes;
+    results[index[k]] = retry_results[k];
+    results[index[k]].nodes += nodes;
+  }
+}
+
+void solve_all(const std::vector<std::unique_ptr<Device>> &devices,
+    const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count,
+    const DispatchOptions &options) {
+  if (!options.sort_by_cost) {
+    solve_unsorted(devices, problems, results, count, options);
+    if (options.escalation) escalate(*options.escalation, problems, results, count);
+    return;
+  }
+  // hardest first, so that the long searches do not end up in the tail
+  std::vector<std::size_t> order(count);
+  std::iota(order.begin(), order.end(), 0);
+  std::vector<int> cost(count);
+  for (std::size_t i = 0; i < count; ++i) cost[i] = estimate_cost(problems[i]);
+  std::stable_sort(order.begin(), order.end(),
+      [&](std::size_t a, std::size_t b) { return cost[a] > cost[b]; });
+  std::vector<AlphaBetaProblem> sorted;
+  sorted.reserve(count);
+  for (std::size_t i : order) sorted.push_back(problems[i]);
+  std::vector<AlphaBetaResult> sorted_results(count);
+  solve_unsorted(devices, sorted.data(), sorted_results.data(), count, options);
+  for (std::size_t i = 0; i < count; ++i) results[order[i]] = sorted_results[i];
+  if (options.escalation) escalate(*options.escalation, problems, results, count);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "device.hpp"
+
+// solves problems[0, count) into results[0, count) on devices set up elsewhere
+typedef std::function<void(const AlphaBetaProblem *, AlphaBetaResult *, std::size_t)> SolveFunction;
+
+struct DispatchOptions {
+  std::size_t max_batch_size; // 0: no limit
+  bool sort_by_cost;
+  Device *escalation; // re-solves problems that ran out of node budget, or null
+};
+
+// estimated search cost, larger is harder
+int estimate_cost(const AlphaBetaProblem &problem);
+
+// Solve problems[0, count) on all devices. Each device pulls the next batch
+// from a shared queue as soon as it finishes the previous one; batch sizes
+// follow each device's measured throughput. Problems suspended by the node
+// budget are then escalated to options.escalation.
+void solve_all(const std::vector<std::unique_ptr<Device>> &devices,
+    const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count,
+    const DispatchOptions &options);
+
+// Re-solves the suspended results[0, count) on device, within the bounds
+// their suspended search established; nodes of both searches add up.
+void escalate(Device &device, const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count);
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "problem_file.hpp"
+#include "workload.hpp"
+
+// Writes N reproducible positions for load tests:
+//   generate [--seed=S] [--playout=uniform|mobility] [--format=text|binary] N EMPTIES[-MAX] OUTPUT
+
+bool starts_with(const std::string &str, const std::string &prefix) {
+  return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+void usage(const char *prog) {
+  std::cerr << "usage: " << prog << " [--seed=S] [--playout=uniform|mobility] [--format=text|binary] N EMPTIES[-MAX] OUTPUT" << std::endl;
+}
+
+int main(int argc, char **argv) {
+  ull seed = 1;
+  Playout playout = Playout::uniform;
+  bool binary = false;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (starts_with(arg, "--seed=")) {
+      seed = std::stoull(arg.substr(7));
+    } else if (arg == "--playout=uniform") {
+      playout = Playout::uniform;
+    } else if (arg == "--playout=mobility") {
+      playout = Playout::mobility;
+    } else if (arg == "--format=text") {
+      binary = false;
+    } else if (arg == "--format=binary") {
+      binary = true;
+    } else if (starts_with(arg, "--")) {
+      usage(argv[0]);
+      return 1;
+    } else {
+      args.push_back(arg);
+    }
+  }
+  if (args.size() != 3) {
+    usage(argv[0]);
+    return 1;
+  }
+  const std::size_t count = std::stoull(args[0]);
+  const std::size_t dash = args[1].find('-');
+  const int min_empties = std::stoi(args[1].substr(0, dash));
+  const int max_empties = dash == std::string::npos ? min_empties : std::stoi(args[1].substr(dash + 1));
+  if (min_empties < 1 || max_empties > 59 || min_empties > max_empties) {
+    std::cerr << "empties must be within 1-59" << std::endl;
+    return 1;
+  }
+  std::vector<AlphaBetaProblem> problems;
+  problems.reserve(count);
+  for (const Board &bd : random_positions(seed, count, min_empties, max_empties, playout)) {
+    problems.push_back(AlphaBetaProblem(bd.me, bd.op));
+  }
+  const bool ok = binary
+    ? write_problems_binary(args[2], problems.data(), problems.size())
+    : write_problems_text(args[2], problems.data(), problems.size());
+  return ok ? 0 : 1;
+}
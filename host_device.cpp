@@ -0,0 +1,49 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <omp.h>
+#include "device.hpp"
+#include "host_solver.hpp"
+
+namespace {
+
+// solves each problem with HostSolver, problems handed out dynamically
+// to OpenMP threads
+class HostDevice : public Device {
+ public:
+  explicit HostDevice(int num_threads)
+    : num_threads(num_threads), total_stats(num_threads, (ThreadStats){0, 0, 0}) {}
+  std::string name() const override {
+    return "host(" + std::to_string(num_threads) + " threads)";
+  }
+  std::size_t min_batch_size() const override {
+    return num_threads * 16;
+  }
+  void solve(const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count) override {
+#pragma omp parallel num_threads(num_threads)
+    {
+      ull nodes = 0;
+#pragma omp for schedule(dynamic)
+      for (std::size_t i = 0; i < count; ++i) {
+        HostSolver solver;
+        const int score = solver.solve(problems[i].me, problems[i].op, problems[i].alpha, problems[i].beta);
+        results[i] = (AlphaBetaResult){solver.nodes, score, false, 0, (unsigned char)(solver.best_move + 1)};
+        nodes += solver.nodes;
+      }
+      total_stats[omp_get_thread_num()].nodes_total += nodes;
+    }
+  }
+  std::vector<ThreadStats> thread_stats() const override {
+    return total_stats;
+  }
+ private:
+  int num_threads;
+  std::vector<ThreadStats> total_stats;
+};
+
+} // namespace
+
+std::unique_ptr<Device> open_host_device(int num_threads) {
+  if (num_threads <= 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+  return std::unique_ptr<Device>(new HostDevice(num_threads));
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include "host_solver.hpp"
+#include "board.hpp"
+#include "solver.hpp"
+
+namespace {
+
+// empties at or below this are searched without sorting the moves
+constexpr int shallow_empties = 6;
+
+constexpr ull corners = UINT64_C(0x8100000000000081);
+constexpr ull quadrants[4] = {
+  UINT64_C(0x000000000F0F0F0F), UINT64_C(0x00000000F0F0F0F0),
+  UINT64_C(0x0F0F0F0F00000000), UINT64_C(0xF0F0F0F000000000)
+};
+
+// empty squares in quadrants with an odd number of empties
+ull odd_regions(ull empty) {
+  ull res = 0;
+  for (ull quadrant : quadrants) {
+    if (popcnt(empty & quadrant) & 1) res |= empty & quadrant;
+  }
+  return res;
+}
+
+struct Move {
+  ull me, op; // the child position, from the opponent's side
+  int key;
+  int pos;
+};
+
+} // namespace
+
+int HostSolver::solve(ull me, ull op, int alpha, int beta) {
+  best_move = -1;
+  return pvs(me, op, alpha, beta, true);
+}
+
+// the root is always searched here, to know its best move
+int HostSolver::pvs(ull me, ull op, int alpha, int beta, bool root) {
+  if (!root && 64 - stones_count(me, op) <= shallow_empties) return shallow(me, op, alpha, beta);
+  ++nodes;
+  int bound;
+  if (stability_cutoff(me, op, alpha, beta, bound)) return bound;
+  ull moves = mobility(me, op);
+  if (!moves) {
+    if (!mobility(op, me)) return final_score(me, op);
+    return -pvs(op, me, -beta, -alpha);
+  }
+  Move list[64];
+  int size = 0;
+  for (; moves; moves &= moves - 1) {
+    const ull bit = moves & -moves;
+    const ull flip_bits = flip(me, op, __builtin_ctzll(bit));
+    Move &move = list[size++];
+    move.me = op ^ flip_bits;
+    move.op = (me ^ flip_bits) | bit;
+    move.key = mobility_count(move.me, move.op) * 2 - ((bit & corners) ? 1 : 0);
+    move.pos = __builtin_ctzll(bit);
+  }
+  std::sort(list, list + size, [](const Move &a, const Move &b) { return a.key < b.key; });
+  int best = -65;
+  for (int i = 0; i < size; ++i) {
+    int value;
+    if (i == 0) {
+      value = -pvs(list[i].me, list[i].op, -beta, -alpha);
+    } else {
+      value = -pvs(list[i].me, list[i].op, -alpha - 1, -alpha);
+      if (alpha < value && value < beta) value = -pvs(list[i].me, list[i].op, -beta, -value);
+    }
+    if (value > best) {
+      best = value;
+      if (root) best_move = list[i].pos;
+      if (value > alpha) {
+        alpha = value;
+        if (alpha >= beta) break;
+      }
+    }
+  }
+  return best;
+}
+
+int HostSolver::shallow(ull me, ull op, int alpha, int beta) {
+  ++nodes;
+  const ull empty = ~(me | op);
+  if (popcnt(empty) == 1) return last1(me, op, __builtin_ctzll(empty));
+  const ull odd = odd_regions(empty);
+  const ull order[2] = {odd, empty & ~odd};
+  int best = -65;
+  for (ull bits : order) {
+    for (; bits; bits &= bits - 1) {
+      const ull bit = bits & -bits;
+      const ull flip_bits = flip(me, op, __builtin_ctzll(bit));
+      if (!flip_bits) continue;
+      const int value = -shallow(op ^ flip_bits, (me ^ flip_bits) | bit, -beta, -alpha);
+      if (value > best) {
+        best = value;
+        if (value > alpha) {
+          alpha = value;
+          if (alpha >= beta) return best;
+        }
+      }
+    }
+  }
+  if (best == -65) { // no legal move
+    if (!mobility(op, me)) return final_score(me, op);
+    return -shallow(op, me, -beta, -alpha);
+  }
+  return best;
+}
+
+// the last empty square is pos
+int HostSolver::last1(ull me, ull op, int pos) {
+  ++nodes;
+  const ull bit = UINT64_C(1) << pos;
+  ull flip_bits = flip(me, op, pos);
+  if (flip_bits) return final_score(me ^ flip_bits ^ bit, op ^ flip_bits);
+  flip_bits = flip(op, me, pos);
+  if (flip_bits) return final_score(me ^ flip_bits, op ^ flip_bits ^ bit);
+  return final_score(me, op);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "types.hpp"
+
+// Sequential endgame solver for the host: principal variation search with
+// fastest-first move ordering (fewest opponent moves, corners first) and,
+// in the last few empties, plain alpha-beta over the squares in regions
+// with an odd number of empties first (parity ordering).
+class HostSolver {
+ public:
+  HostSolver() : nodes(0), best_move(-1) {}
+  // fail-soft score of (me, op) within (alpha, beta), exact for (-64, 64)
+  int solve(ull me, ull op, int alpha = -64, int beta = 64);
+  ull nodes;
+  int best_move; // square of the root move with the best score, -1: none
+ private:
+  int pvs(ull me, ull op, int alpha, int beta, bool root = false);
+  int shallow(ull me, ull op, int alpha, int beta);
+  int last1(ull me, ull op, int pos);
+};
@@ -0,0 +1,36 @@
+#include <cstdio>
+#include "board.hpp"
+#include "host_solver.hpp"
+
+// Checks of HostSolver, the verifier of every backend.
+//   make test
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+  if (!ok) {
+    std::printf("FAIL: %s\n", what);
+    ++failures;
+  }
+}
+
+// a root with more legal moves than fit in 32 slots: the first move puts a
+// stable disc down, so the window just above the stable-disc bound fails
+// high at once
+void root_with_34_moves() {
+  const ull me = UINT64_C(0x0c048684410620a0), op = UINT64_C(0x00ca40480a405e00);
+  check(mobility_count(me, op) > 32, "position has more than 32 moves");
+  const int alpha = 2 * stable_count(me, op) - 64;
+  HostSolver solver;
+  check(solver.solve(me, op, alpha, alpha + 1) > alpha, "fails high above the stable-disc bound");
+}
+
+} // namespace
+
+int main() {
+  root_with_34_moves();
+  std::printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
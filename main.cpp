@@ -4,375 +4,577 @@
 #include <chrono>
 #include <iostream>
 #include <fstream>
-#include <random>
 #include <utility>
+#include <string>
+#include <thread>
 #include <omp.h>
-#include <PZSDKHelper.h>
-#include <pzcl/pzcl_ocl_wrapper.h>
 #include "types.hpp"
+#include "board.hpp"
 #include "solver.hpp"
+#include "device.hpp"
+#include "dispatch.hpp"
+#include "split.hpp"
+#include "mtdf.hpp"
+#include "symmetry.hpp"
+#include "result_cache.hpp"
+#include "pipeline.hpp"
+#include "service.hpp"
+#include "pv.hpp"
+#include "shard.hpp"
+#include "report.hpp"
+#include "problem_file.hpp"
 #include "to_board.hpp"
+#include "host_solver.hpp"
 
-// parameters
-constexpr size_t lower_stack_size = 10;
-constexpr size_t upper_stack_size = 1;
-
-int popcnt(uint64_t x) {
-  x = ((x & UINT64_C(0xAAAAAAAAAAAAAAAA)) >>  1) + (x & UINT64_C(0x5555555555555555));
-  x = ((x & UINT64_C(0xCCCCCCCCCCCCCCCC)) >>  2) + (x & UINT64_C(0x3333333333333333));
-  x = ((x & UINT64_C(0xF0F0F0F0F0F0F0F0)) >>  4) + (x & UINT64_C(0x0F0F0F0F0F0F0F0F));
-  x = ((x & UINT64_C(0xFF00FF00FF00FF00)) >>  8) + (x & UINT64_C(0x00FF00FF00FF00FF));
-  x = ((x & UINT64_C(0xFFFF0000FFFF0000)) >> 16) + (x & UINT64_C(0x0000FFFF0000FFFF));
-  return ((x >> 32) + x) & UINT64_C(0x00000000FFFFFFFF);
-}
-
-int score(const Board& bd) {
-  int me = popcnt(bd.me);
-  int op = popcnt(bd.op);
-  if (me == op) return 0;
-  if (me > op) return 64 - 2*op;
-  else return -64 + 2*me;
+std::string to_string(const Board& bd) {
+  std::string res;
+  for (int i = 0; i < 8; ++i) {
+    for (int j = 0; j < 8; ++j) {
+      int index = i*8+j;
+      if ((bd.me >> index) & 1) {
+        res += 'x';
+      } else if ((bd.op >> index) & 1) {
+        res += 'o';
+      } else {
+        res += ' ';
+      }
+    }
+    res += '\n';
+  }
+  return res;
 }
 
-uint64_t empty(const Board& bd) {
-  return ~(bd.me | bd.op);
-}
+struct Options {
+  std::string backend = "pzcl";
+  std::string mode = "exact";
+  int threshold = 0;
+  int threads = 0;
+  int host_threads = 0;
+  std::size_t batch_size = 0;
+  std::size_t upper_stack_size = 0; // 0: upper_stack_size_for the input
+  std::size_t work_items = 0;
+  std::size_t table_size = 64; // MiB
+  bool sort = false;
+  bool dedup = true;
+  int split_depth = 0;
+  int split_min_empties = 16;
+  std::size_t fastest_first_empties = 0;
+  std::size_t node_budget = 0;
+  int pv = 0; // moves of principal variation written, 0: none
+  std::string ordering = "mobility";
+  std::size_t ordering_empties = 16;
+  std::string eval_path;
+  std::string report_path;
+  std::string cache_path;
+  std::size_t cache_size = 256; // MiB
+  bool binary_output = false;
+  bool pipeline = false;
+  bool serve = false;
+  std::string socket_path; // empty: serve stdin
+  int batch_window = 5; // ms
+  std::string shard; // "K/N", empty: not sharded
+  std::string shard_by = "range";
+  std::size_t checkpoint_every = 65536; // problems per shard file append
+  int verify_percent = 100;
+  std::string kernel_path = "kernel.sc1-64/solver.pz";
+  std::vector<std::string> args;
+};
 
-uint64_t upper_bit(uint64_t x) {
-  x |= x >> 1;
-  x |= x >> 2;
-  x |= x >> 4;
-  x |= x >> 8;
-  x |= x >> 16;
-  x |= x >> 32;
-  return x & ~(x >> 1);
+bool starts_with(const std::string &str, const std::string &prefix) {
+  return str.compare(0, prefix.size(), prefix) == 0;
 }
 
-template <int simd_index>
-uint64_t flip_impl(const Board& bd, int pos) {
-  uint64_t OM = bd.op;
-  if (simd_index) OM &= UINT64_C(0x7E7E7E7E7E7E7E7E);
-  constexpr uint64_t mask1[] = {
-    UINT64_C(0x0080808080808080),
-    UINT64_C(0x7F00000000000000),
-    UINT64_C(0x0102040810204000),
-    UINT64_C(0x0040201008040201)
-  };
-  uint64_t mask = mask1[simd_index] >> (63 - pos);
-  uint64_t outflank = upper_bit(~OM & mask) & bd.me;
-  uint64_t flipped = (-outflank << 1) & mask;
-  constexpr uint64_t mask2[] = {
-    UINT64_C(0x0101010101010100),
-    UINT64_C(0x00000000000000FE),
-    UINT64_C(0x0002040810204080),
-    UINT64_C(0x8040201008040200)
-  };
-  mask = mask2[simd_index] << pos;
-  outflank = mask & ((OM | ~mask) + 1) & bd.me;
-  flipped |= (outflank - (outflank != 0)) & mask;
-  return flipped;
+Options parse_options(int argc, char **argv) {
+  Options opt;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (starts_with(arg, "--backend=")) {
+      opt.backend = arg.substr(10);
+    } else if (starts_with(arg, "--mode=")) {
+      opt.mode = arg.substr(7);
+    } else if (starts_with(arg, "--threshold=")) {
+      opt.threshold = std::stoi(arg.substr(12));
+    } else if (starts_with(arg, "--host-threads=")) {
+      opt.host_threads = std::stoi(arg.substr(15));
+    } else if (starts_with(arg, "--threads=")) {
+      opt.threads = std::stoi(arg.substr(10));
+    } else if (starts_with(arg, "--batch-size=")) {
+      opt.batch_size = std::stoul(arg.substr(13));
+    } else if (starts_with(arg, "--upper-stack-size=")) {
+      opt.upper_stack_size = std::stoul(arg.substr(19));
+    } else if (starts_with(arg, "--work-items=")) {
+      opt.work_items = std::stoul(arg.substr(13));
+    } else if (starts_with(arg, "--table-size=")) {
+      opt.table_size = std::stoul(arg.substr(13));
+    } else if (starts_with(arg, "--split=")) {
+      opt.split_depth = std::stoi(arg.substr(8));
+    } else if (starts_with(arg, "--split-min-empties=")) {
+      opt.split_min_empties = std::stoi(arg.substr(20));
+    } else if (starts_with(arg, "--fastest-first=")) {
+      opt.fastest_first_empties = std::stoul(arg.substr(16));
+    } else if (starts_with(arg, "--ordering=")) {
+      opt.ordering = arg.substr(11);
+    } else if (starts_with(arg, "--ordering-empties=")) {
+      opt.ordering_empties = std::stoul(arg.substr(19));
+    } else if (starts_with(arg, "--eval=")) {
+      opt.eval_path = arg.substr(7);
+    } else if (starts_with(arg, "--pv=")) {
+      opt.pv = std::max(0, std::stoi(arg.substr(5)));
+    } else if (starts_with(arg, "--node-budget=")) {
+      opt.node_budget = std::stoul(arg.substr(14));
+    } else if (starts_with(arg, "--cache=")) {
+      opt.cache_path = arg.substr(8);
+    } else if (starts_with(arg, "--cache-size=")) {
+      opt.cache_size = std::stoul(arg.substr(13));
+    } else if (starts_with(arg, "--report=")) {
+      opt.report_path = arg.substr(9);
+    } else if (starts_with(arg, "--verify=")) {
+      opt.verify_percent = std::min(100, std::max(0, std::stoi(arg.substr(9))));
+    } else if (arg == "--output-format=binary") {
+      opt.binary_output = true;
+    } else if (arg == "--output-format=text") {
+      opt.binary_output = false;
+    } else if (arg == "--serve") {
+      opt.serve = true;
+    } else if (starts_with(arg, "--serve=")) {
+      opt.serve = true;
+      opt.socket_path = arg.substr(8);
+    } else if (starts_with(arg, "--batch-window=")) {
+      opt.batch_window = std::max(0, std::stoi(arg.substr(15)));
+    } else if (starts_with(arg, "--shard=")) {
+      opt.shard = arg.substr(8);
+    } else if (starts_with(arg, "--shard-by=")) {
+      opt.shard_by = arg.substr(11);
+    } else if (starts_with(arg, "--checkpoint-every=")) {
+      opt.checkpoint_every = std::max(1ul, std::stoul(arg.substr(19)));
+    } else if (arg == "--pipeline") {
+      opt.pipeline = true;
+    } else if (arg == "--sort") {
+      opt.sort = true;
+    } else if (arg == "--no-dedup") {
+      opt.dedup = false;
+    } else if (starts_with(arg, "--kernel=")) {
+      opt.kernel_path = arg.substr(9);
+    } else {
+      opt.args.push_back(arg);
+    }
+  }
+  return opt;
 }
 
-uint64_t flip(const Board& bd, int pos) {
-  return flip_impl<0>(bd, pos) | flip_impl<1>(bd, pos) | flip_impl<2>(bd, pos) | flip_impl<3>(bd, pos);
+void usage(const char *prog) {
+  std::cerr << "usage: " << prog << " [--backend=cpu|host|pzcl] [--mode=exact|mtdf|wld|test] [--threshold=T] [--threads=N] [--host-threads=N] [--batch-size=N] [--pipeline] [--sort] [--no-dedup] [--upper-stack-size=N] [--work-items=N] [--table-size=MiB] [--split=DEPTH] [--split-min-empties=N] [--fastest-first=EMPTIES] [--ordering=mobility|pattern|shallow] [--ordering-empties=N] [--eval=PATH] [--node-budget=N] [--pv=N] [--cache=PATH] [--cache-size=MiB] [--report=PATH] [--output-format=text|binary] [--verify=PERCENT] [--kernel=PATH] INPUT OUTPUT" << std::endl;
+  std::cerr << "       " << prog << " --serve[=SOCKET] [--batch-window=MS] [solver options]" << std::endl;
+  std::cerr << "       " << prog << " --shard=K/N [--shard-by=range|hash] [--checkpoint-every=N] [solver options] INPUT SHARD_FILE" << std::endl;
 }
 
-Board move(const Board& bd, uint64_t flips, int pos) {
-  return Board(bd.op ^ flips, (bd.me ^ flips) | (UINT64_C(1) << pos));
+std::vector<std::unique_ptr<Device>> open_devices(const Options &opt, const SolverConfig &config) {
+  std::vector<std::unique_ptr<Device>> devices;
+  if (opt.backend == "cpu") {
+    devices.push_back(open_cpu_device(opt.threads, config));
+  } else if (opt.backend == "host") {
+    devices.push_back(open_host_device(opt.threads));
+  } else if (opt.backend == "pzcl") {
+#ifndef WITHOUT_PZCL
+    devices = open_pzcl_devices(opt.kernel_path.c_str(), config);
+#else
+    std::cerr << "built without PZSDK; use --backend=cpu" << std::endl;
+#endif
+  } else {
+    std::cerr << "unknown backend: " << opt.backend << std::endl;
+  }
+  // host cores as one more worker next to the accelerators
+  if (!devices.empty() && opt.host_threads > 0) devices.push_back(open_host_device(opt.host_threads));
+  return devices;
 }
 
-Board unmove(const Board& bd, uint64_t flips, int pos) {
-  return Board(bd.op ^ flips ^ (UINT64_C(1) << pos), bd.me ^ flips);
+// the host solver, without a node budget, takes over the problems that
+// exhaust it on the devices
+std::unique_ptr<Device> open_escalation_device(const Options &opt) {
+  if (opt.node_budget == 0) return nullptr;
+  return open_host_device(opt.host_threads > 0 ? opt.host_threads : opt.threads);
 }
 
-Board move_pass(const Board& bd) {
-  return Board(bd.op, bd.me);
+void print_escalation(const Device *escalation) {
+  if (!escalation) return;
+  const DeviceUsage &usage = escalation->usage();
+  std::cerr << "escalated: " << usage.problems << " problems in " << usage.seconds << " s" << std::endl;
 }
 
-Board unmove_pass(const Board &bd) {
-  return Board(bd.op, bd.me);
+void run_solver(const std::vector<std::unique_ptr<Device>> &devices, Device *escalation, const Options &opt,
+    const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count) {
+  const DispatchOptions dispatch = {opt.batch_size, opt.sort, escalation};
+  const SplitOptions split = {opt.split_depth, opt.split_min_empties};
+  if (opt.mode == "mtdf") {
+    const int rounds = solve_mtdf(devices, problems, results, count, dispatch, split);
+    std::cerr << "mtdf: " << rounds << " rounds" << std::endl;
+  } else if (opt.split_depth > 0) {
+    solve_split(devices, problems, results, count, dispatch, split);
+  } else {
+    solve_all(devices, problems, results, count, dispatch);
+  }
 }
 
-struct Search {
-  Board bd;
-  signed char alpha_beta(signed char alpha, signed char beta, bool passed_prev = false) {
-    signed char result = -64;
-    bool pass = true;
-    for (uint64_t bits = empty(bd); bits; bits &= bits-1) {
-      uint64_t flips, pos;
-      {
-        uint64_t bit = bits & -bits;
-        pos = popcnt(bit - 1);
-        flips = flip(bd, pos);
-      }
-      if (flips) {
-        pass = false;
-        bd = move(bd, flips, pos);
-        result = std::max(result, (signed char)-alpha_beta(-beta, -alpha));
-        bd = unmove(bd, flips, pos);
-        if (result >= beta) return result;
-        alpha = std::max(alpha, result);
+// run_solver for the problems that are left after positions equal up to
+// symmetry are merged (unless --no-dedup) and the cache settled what it can
+void solve_problems(const std::vector<std::unique_ptr<Device>> &devices, Device *escalation, const Options &opt,
+    ResultCache &cache, const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count) {
+  std::vector<AlphaBetaProblem> unique;
+  std::vector<std::size_t> unique_index;
+  std::vector<AlphaBetaResult> unique_results;
+  const AlphaBetaProblem *solve_problems = problems;
+  AlphaBetaResult *solve_results = results;
+  std::size_t solve_count = count;
+  if (opt.dedup) {
+    dedup_problems(problems, count, unique, unique_index);
+    unique_results.resize(unique.size());
+    solve_problems = unique.data();
+    solve_results = unique_results.data();
+    solve_count = unique.size();
+    std::cerr << "unique: " << solve_count << std::endl;
+  }
+  if (cache.enabled()) {
+    // only the problems the cache does not settle go to the devices
+    std::vector<AlphaBetaProblem> pending;
+    std::vector<std::size_t> pending_index;
+    const std::size_t hits = cache.hits;
+    for (std::size_t i = 0; i < solve_count; ++i) {
+      if (!cache.find(solve_problems[i], solve_results[i])) {
+        pending.push_back(solve_problems[i]);
+        pending_index.push_back(i);
       }
     }
-    if (pass) {
-      if (passed_prev) {
-        return score(bd);
-      } else {
-        bd = move_pass(bd);
-        result = -alpha_beta(-beta, -alpha, true);
-        bd = unmove_pass(bd);
-      }
+    std::cerr << "cache hits: " << cache.hits - hits << std::endl;
+    std::vector<AlphaBetaResult> pending_results(pending.size());
+    run_solver(devices, escalation, opt, pending.data(), pending_results.data(), pending.size());
+    for (std::size_t k = 0; k < pending.size(); ++k) {
+      solve_results[pending_index[k]] = pending_results[k];
+      cache.update(pending[k], pending_results[k]);
     }
-    return result;
+  } else {
+    run_solver(devices, escalation, opt, solve_problems, solve_results, solve_count);
   }
-};
+  if (opt.dedup) {
+    for (std::size_t i = 0; i < count; ++i) {
+      const AlphaBetaProblem &first = unique[unique_index[i]];
+      results[i] = unique_results[unique_index[i]];
+      results[i].move = map_move(Board(first.me, first.op), Board(problems[i].me, problems[i].op), results[i].move);
+    }
+  }
+}
 
-constexpr int MAX_BIN_SIZE = 1000000;
+// re-solves on the host the problems whose input index (index[i], or i if
+// index is null) is in the deterministic sample of --verify; the others
+// get no_answer. Adds the error of inconsistent scores to diff and returns
+// how many problems were verified.
+std::size_t verify_results(const Options &opt, const AlphaBetaProblem *problems, const AlphaBetaResult *results,
+    std::size_t count, const std::size_t *index, std::vector<int> &answers, uint64_t &diff) {
+  std::vector<std::size_t> sample;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (in_verify_sample(index ? index[i] : i, opt.verify_percent)) sample.push_back(i);
+  }
+  answers.assign(count, no_answer);
+#pragma omp parallel for schedule(dynamic)
+  for (std::size_t k = 0; k < sample.size(); ++k) {
+    const std::size_t i = sample[k];
+    HostSolver solver;
+    answers[i] = solver.solve(problems[i].me, problems[i].op);
+  }
+  for (std::size_t i : sample) {
+    if (!consistent(problems[i], results[i].score, answers[i])) diff += abs(results[i].score - answers[i]);
+  }
+  return sample.size();
+}
 
-const char *getErrorString(cl_int error)
-{
-  switch(error){
-    case 0: return "CL_SUCCESS";
-    case -1: return "CL_DEVICE_NOT_FOUND";
-    case -2: return "CL_DEVICE_NOT_AVAILABLE";
-    case -3: return "CL_COMPILER_NOT_AVAILABLE";
-    case -4: return "CL_MEM_OBJECT_ALLOCATION_FAILURE";
-    case -5: return "CL_OUT_OF_RESOURCES";
-    case -6: return "CL_OUT_OF_HOST_MEMORY";
-    case -7: return "CL_PROFILING_INFO_NOT_AVAILABLE";
-    case -8: return "CL_MEM_COPY_OVERLAP";
-    case -9: return "CL_IMAGE_FORMAT_MISMATCH";
-    case -10: return "CL_IMAGE_FORMAT_NOT_SUPPORTED";
-    case -11: return "CL_BUILD_PROGRAM_FAILURE";
-    case -12: return "CL_MAP_FAILURE";
-    case -13: return "CL_MISALIGNED_SUB_BUFFER_OFFSET";
-    case -14: return "CL_EXEC_STATUS_ERROR_FOR_EVENTS_IN_WAIT_LIST";
-    case -15: return "CL_COMPILE_PROGRAM_FAILURE";
-    case -16: return "CL_LINKER_NOT_AVAILABLE";
-    case -17: return "CL_LINK_PROGRAM_FAILURE";
-    case -18: return "CL_DEVICE_PARTITION_FAILED";
-    case -19: return "CL_KERNEL_ARG_INFO_NOT_AVAILABLE";
-    case -30: return "CL_INVALID_VALUE";
-    case -31: return "CL_INVALID_DEVICE_TYPE";
-    case -32: return "CL_INVALID_PLATFORM";
-    case -33: return "CL_INVALID_DEVICE";
-    case -34: return "CL_INVALID_CONTEXT";
-    case -35: return "CL_INVALID_QUEUE_PROPERTIES";
-    case -36: return "CL_INVALID_COMMAND_QUEUE";
-    case -37: return "CL_INVALID_HOST_PTR";
-    case -38: return "CL_INVALID_MEM_OBJECT";
-    case -39: return "CL_INVALID_IMAGE_FORMAT_DESCRIPTOR";
-    case -40: return "CL_INVALID_IMAGE_SIZE";
-    case -41: return "CL_INVALID_SAMPLER";
-    case -42: return "CL_INVALID_BINARY";
-    case -43: return "CL_INVALID_BUILD_OPTIONS";
-    case -44: return "CL_INVALID_PROGRAM";
-    case -45: return "CL_INVALID_PROGRAM_EXECUTABLE";
-    case -46: return "CL_INVALID_KERNEL_NAME";
-    case -47: return "CL_INVALID_KERNEL_DEFINITION";
-    case -48: return "CL_INVALID_KERNEL";
-    case -49: return "CL_INVALID_ARG_INDEX";
-    case -50: return "CL_INVALID_ARG_VALUE";
-    case -51: return "CL_INVALID_ARG_SIZE";
-    case -52: return "CL_INVALID_KERNEL_ARGS";
-    case -53: return "CL_INVALID_WORK_DIMENSION";
-    case -54: return "CL_INVALID_WORK_GROUP_SIZE";
-    case -55: return "CL_INVALID_WORK_ITEM_SIZE";
-    case -56: return "CL_INVALID_GLOBAL_OFFSET";
-    case -57: return "CL_INVALID_EVENT_WAIT_LIST";
-    case -58: return "CL_INVALID_EVENT";
-    case -59: return "CL_INVALID_OPERATION";
-    case -60: return "CL_INVALID_GL_OBJECT";
-    case -61: return "CL_INVALID_BUFFER_SIZE";
-    case -62: return "CL_INVALID_MIP_LEVEL";
-    case -63: return "CL_INVALID_GLOBAL_WORK_SIZE";
-    case -64: return "CL_INVALID_PROPERTY";
-    case -65: return "CL_INVALID_IMAGE_DESCRIPTOR";
-    case -66: return "CL_INVALID_COMPILER_OPTIONS";
-    case -67: return "CL_INVALID_LINKER_OPTIONS";
-    case -68: return "CL_INVALID_DEVICE_PARTITION_COUNT";
+// stacks deep enough for positions with up to max_empties empties; shallow
+// ordering evaluates with the pattern weights if there are any
+SolverConfig solver_config(const Options &opt, int max_empties, const std::vector<short> &weights) {
+  std::size_t ordering = 0;
+  if (opt.ordering != "mobility" && !weights.empty()) ordering |= ordering_pattern;
+  if (opt.ordering == "shallow") ordering |= ordering_shallow;
+  const std::size_t upper = opt.upper_stack_size ? opt.upper_stack_size : upper_stack_size_for(max_empties);
+  // only upper nodes below the root are stored, so a single upper frame
+  // never reaches the table
+  const std::size_t table = upper > 1 ? table_entries_for(opt.table_size) : 0;
+  const SolverConfig config = {upper, lower_stack_size_for(max_empties, upper),
+    table, opt.fastest_first_empties, opt.work_items, opt.node_budget,
+    ordering, opt.ordering_empties, weights.empty() ? nullptr : weights.data()};
+  std::cerr << "stack: " << stack_bytes_per_thread(config) << " bytes/thread ("
+    << config.upper_stack_size << " x " << sizeof(UpperNode) << " upper, "
+    << config.lower_stack_size << " x " << sizeof(Node) << " lower)" << std::endl;
+  return config;
+}
 
-    case -1000: return "CL_INVALID_GL_SHAREGROUP_REFERENCE_KHR";
-    case -1001: return "CL_PLATFORM_NOT_FOUND_KHR";
-    case -1002: return "CL_INVALID_D3D10_DEVICE_KHR";
-    case -1003: return "CL_INVALID_D3D10_RESOURCE_KHR";
-    case -1004: return "CL_D3D10_RESOURCE_ALREADY_ACQUIRED_KHR";
-    case -1005: return "CL_D3D10_RESOURCE_NOT_ACQUIRED_KHR";
-    default: return "Unknown OpenCL error";
+// window that opt.mode imposes on every problem; false if the loaded
+// windows are kept
+bool mode_window(const Options &opt, int &alpha, int &beta) {
+  if (opt.mode == "wld") {
+    alpha = -1;
+    beta = 1;
+    return true;
+  } else if (opt.mode == "test") { // is the score at least threshold?
+    alpha = opt.threshold - 1;
+    beta = opt.threshold;
+    return true;
   }
+  return false;
 }
 
-using pfnPezyExtSetPerThreadStackSize = CL_API_ENTRY cl_int (CL_API_CALL *) (pzcl_kernel kernel, size_t size);
-
-std::string to_string(const Board& bd) {
-  std::string res;
-  for (int i = 0; i < 8; ++i) {
-    for (int j = 0; j < 8; ++j) {
-      int index = i*8+j;
-      if ((bd.me >> index) & 1) {
-        res += 'x';
-      } else if ((bd.op >> index) & 1) {
-        res += 'o';
-      } else {
-        res += ' ';
-      }
+void print_stats(const std::vector<std::unique_ptr<Device>> &devices, double elapsed) {
+  std::cerr << "elapsed: " << elapsed << std::endl;
+  ull nodes = 0, table_hits = 0, table_misses = 0;
+  for (const auto &device : devices) {
+    for (const ThreadStats &stats : device->thread_stats()) {
+      nodes += stats.nodes_total;
+      table_hits += stats.table_hits;
+      table_misses += stats.table_misses;
     }
-    res += '\n';
   }
-  return res;
+  std::cerr << "nodes: " << nodes << ", nps: " << nodes / elapsed << std::endl;
+  std::cerr << "table hits: " << table_hits << ", misses: " << table_misses << std::endl;
 }
 
-int main(int argc, char **argv) {
-  std::ifstream fin(argv[1]);
-  std::size_t N;
-  fin >> N;
-  std::cerr << "N = " << N << std::endl;
-  std::vector<AlphaBetaProblem> problems;
-  std::vector<std::string> board_str_vec;
-  for (std::size_t i = 0; i < N; ++i) {
-    std::string b81;
-    fin >> b81;
-    const Board bd = toBoard(b81.c_str());
-    problems.push_back((AlphaBetaProblem){bd.me, bd.op, -64, 64});
-    board_str_vec.push_back(b81);
+// streams the input through the devices batch by batch
+int run_pipelined(const Options &opt, const std::vector<std::unique_ptr<Device>> &devices, Device *escalation) {
+  if (opt.mode == "mtdf" || opt.split_depth > 0 || opt.sort || !opt.cache_path.empty() || !opt.report_path.empty()) {
+    std::cerr << "--pipeline does not support --mode=mtdf, --split, --sort, --cache or --report" << std::endl;
+    return 1;
   }
-
-  cl_platform_id platform_id = nullptr;
-  cl_uint num_platforms = 0;
-  cl_int result = 0;
-  result = clGetPlatformIDs(1, &platform_id, &num_platforms);
-  std::cerr << "Number of platforms: " << num_platforms << std::endl;
-
-  cl_uint num_devices = 0;
-  result = clGetDeviceIDs(platform_id, CL_DEVICE_TYPE_DEFAULT, 0, nullptr, &num_devices);
-  std::cerr << "Number of devices: " << num_devices << std::endl;
-
-  std::vector<cl_device_id> device_ids(num_devices);
-  result = clGetDeviceIDs(platform_id, CL_DEVICE_TYPE_DEFAULT, num_devices, device_ids.data(), nullptr);
-
-  std::cerr << "load program" << std::endl;
-  unsigned char *binary = (unsigned char *)malloc(MAX_BIN_SIZE * sizeof(char));
-  FILE *fp = fopen("kernel.sc1-64/solver.pz", "rb");
-  std::size_t size = fread(binary, sizeof(char), MAX_BIN_SIZE, fp);
-  fclose(fp);
-
-  std::vector<cl_context> contexts;
-  std::vector<cl_command_queue> command_queues;
-  std::vector<cl_program> programs;
-  std::vector<cl_kernel> kernels;
-  std::vector<cl_mem> mem_probs;
-  std::vector<cl_mem> mem_results;
-  std::vector<cl_mem> mem_ustacks;
-  std::vector<cl_mem> mem_lstacks;
-  std::vector<cl_mem> mem_numnodes;
-
-  const size_t chunk_size = (N + num_devices - 1) / num_devices;
-  constexpr size_t global_work_size = 8192; // max size
-
-  for (cl_uint i = 0; i < num_devices; ++i) {
-    std::cerr << "Device " << i << std::endl;
-    cl_device_id device_id = device_ids[i];
-
-    cl_context context = clCreateContext(nullptr, 1, &device_id, nullptr, nullptr, &result);
-    contexts.push_back(context);
-
-    cl_command_queue command_queue = clCreateCommandQueue(context, device_id, 0, &result);
-    command_queues.push_back(command_queue);
-
-    std::cerr << "create program" << std::endl;
-    cl_int binary_status = 0;
-    cl_program program = clCreateProgramWithBinary(context, 1, &device_id, &size, (const unsigned char **)&binary, &binary_status, &result);
-    programs.push_back(program);
-  
-    std::cerr << "create kernel" << std::endl;
-    cl_kernel kernel = clCreateKernel(program, "Solve", &result);
-    kernels.push_back(kernel);
-
-    std::cerr << "create buffer" << std::endl;
-    const size_t real_chunk_size = std::min(chunk_size, N - i * chunk_size);
-    cl_mem memProb = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(AlphaBetaProblem)*real_chunk_size, nullptr, &result);
-    cl_mem memRes = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(int32_t)*real_chunk_size, nullptr, &result);
-    cl_mem memUStack = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(UpperNode)*global_work_size*upper_stack_size, nullptr, &result);
-    cl_mem memLStack = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(Node)*global_work_size*lower_stack_size, nullptr, &result);
-    cl_mem memNodesTotal = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(uint64_t)*global_work_size, nullptr, &result);
-    mem_probs.push_back(memProb);
-    mem_results.push_back(memRes);
-    mem_ustacks.push_back(memUStack);
-    mem_lstacks.push_back(memLStack);
-    mem_numnodes.push_back(memNodesTotal);
-
-    clEnqueueWriteBuffer(command_queue, memProb, CL_TRUE, 0, sizeof(AlphaBetaProblem)*real_chunk_size, &problems[i * chunk_size], 0, nullptr, nullptr);
-
-    // pfnPezyExtSetPerThreadStackSize clExtSetPerThreadStackSize = (pfnPezyExtSetPerThreadStackSize)clGetExtensionFunctionAddress("pezy_set_per_thread_stack_size");
-    // constexpr size_t per_thread_stack = 0x1000;
-    // result = clExtSetPerThreadStackSize(kernel, per_thread_stack);
-    // if (result != CL_SUCCESS) {
-    //   std::cerr << getErrorString(result) << std::endl;
-    // }
+  if (opt.pv > 1) {
+    std::cerr << "--pipeline writes only the best move, use --pv=1" << std::endl;
+    return 1;
+  }
+  ProblemReader reader;
+  if (!reader.open(opt.args[0])) return 1;
+  std::cerr << "N = " << reader.size() << std::endl;
+  ResultWriter writer;
+  if (!writer.open(opt.args[1], reader.size(), opt.binary_output)) return 1;
+  std::size_t batch_size = opt.batch_size;
+  if (batch_size == 0) {
+    for (const auto &device : devices) batch_size = std::max(batch_size, 4 * device->min_batch_size());
   }
+  PipelineOptions options = {batch_size, false, -64, 64, opt.mode == "wld", opt.verify_percent, escalation, opt.pv > 0};
+  options.set_window = mode_window(opt, options.alpha, options.beta);
+  auto start = std::chrono::system_clock::now();
+  std::cerr << "start" << std::endl;
+  PipelineStats stats;
+  const bool ok = solve_pipelined(devices, reader, writer, options, stats);
+  auto end = std::chrono::system_clock::now();
+  print_stats(devices, std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count());
+  print_escalation(escalation);
+  std::cerr << "verified: " << stats.verified << std::endl;
+  std::cerr << "diff: " << stats.diff << std::endl;
+  return ok ? 0 : 1;
+}
 
-  free(binary);
+// answers requests from stdin or a Unix domain socket with devices that
+// stay initialized between batches
+int run_service(const Options &opt, const std::vector<std::unique_ptr<Device>> &devices, Device *escalation) {
+  if (opt.pipeline || !opt.cache_path.empty() || !opt.report_path.empty()) {
+    std::cerr << "--serve does not support --pipeline, --cache or --report" << std::endl;
+    return 1;
+  }
+  if (opt.pv > 1) {
+    std::cerr << "--serve answers only the best move, use --pv=1" << std::endl;
+    return 1;
+  }
+  std::size_t batch_size = opt.batch_size;
+  if (batch_size == 0) {
+    for (const auto &device : devices) batch_size = std::max(batch_size, device->min_batch_size());
+  }
+  ServiceOptions options = {batch_size, opt.batch_window, false, -64, 64, opt.mode == "wld", opt.pv > 0};
+  options.set_window = mode_window(opt, options.alpha, options.beta);
+  const SolveFunction solve = [&](const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count) {
+    run_solver(devices, escalation, opt, problems, results, count);
+  };
+  auto start = std::chrono::system_clock::now();
+  ServiceStats stats;
+  const bool ok = serve(opt.socket_path, solve, options, stats);
+  auto end = std::chrono::system_clock::now();
+  print_stats(devices, std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count());
+  print_escalation(escalation);
+  std::cerr << "served: " << stats.requests << " requests in " << stats.batches << " batches" << std::endl;
+  return ok ? 0 : 1;
+}
 
+// solves the problems of one shard of the input chunk by chunk and appends
+// every finished chunk to the shard file opt.args[1]; the problems already
+// in it from an earlier, interrupted run are skipped
+int run_sharded(const Options &opt, const ShardSpec &spec, const ProblemSet &problem_set, ull input,
+    const std::vector<short> &pattern_weights) {
+  if (!opt.report_path.empty() || opt.binary_output || opt.pv > 1) {
+    std::cerr << "--shard does not support --report, --output-format or --pv above 1 (merge writes the output)" << std::endl;
+    return 1;
+  }
+  const std::size_t N = problem_set.size();
+  const AlphaBetaProblem * const problems = problem_set.data();
+  ShardFile shard_file;
+  if (!shard_file.open(opt.args[1], spec, input, N)) return 1;
+  std::vector<bool> done(N, false);
+  for (const ShardRecord &record : shard_file.records()) {
+    if (record.index < N) done[record.index] = true;
+  }
+  std::vector<std::size_t> pending;
+  std::size_t shard_size = 0;
+  int max_empties = 0;
+  for (std::size_t i = 0; i < N; ++i) {
+    if (!in_shard(spec, problems[i], i, N)) continue;
+    ++shard_size;
+    if (done[i]) continue;
+    pending.push_back(i);
+    max_empties = std::max(max_empties, 64 - stones_count(problems[i].me, problems[i].op));
+  }
+  std::cerr << "shard " << spec.shard << "/" << spec.shards << ": " << shard_size << " problems, "
+    << shard_size - pending.size() << " done" << std::endl;
+  if (pending.empty()) return 0;
+
+  const SolverConfig config = solver_config(opt, max_empties, pattern_weights);
+  std::vector<std::unique_ptr<Device>> devices = open_devices(opt, config);
+  if (devices.empty()) {
+    std::cerr << "no device available" << std::endl;
+    return 1;
+  }
+  std::unique_ptr<Device> escalation = open_escalation_device(opt);
+  ResultCache cache;
+  if (!opt.cache_path.empty() && !cache.open(opt.cache_path, opt.cache_size)) return 1;
   auto start = std::chrono::system_clock::now();
   std::cerr << "start" << std::endl;
-  for (cl_uint i = 0; i < num_devices; ++i) {
-    const size_t real_chunk_size = std::min(chunk_size, N - i * chunk_size);
-
-    clSetKernelArg(kernels[i], 0, sizeof(cl_mem), (void *)&mem_probs[i]);
-    clSetKernelArg(kernels[i], 1, sizeof(cl_mem), (void *)&mem_results[i]);
-    clSetKernelArg(kernels[i], 2, sizeof(cl_mem), (void *)&mem_ustacks[i]);
-    clSetKernelArg(kernels[i], 3, sizeof(cl_mem), (void *)&mem_lstacks[i]);
-    clSetKernelArg(kernels[i], 4, sizeof(size_t), (void *)&real_chunk_size);
-    clSetKernelArg(kernels[i], 5, sizeof(size_t), (void *)&upper_stack_size);
-    clSetKernelArg(kernels[i], 6, sizeof(size_t), (void *)&lower_stack_size);
-    clSetKernelArg(kernels[i], 7, sizeof(cl_mem), (void *)&mem_numnodes[i]);
-  
-    result = clEnqueueNDRangeKernel(command_queues[i], kernels[i], 1, nullptr, &global_work_size, nullptr, 0, nullptr, nullptr);
-    if (result != CL_SUCCESS) {
-      std::cerr << "kernel launch error: " << getErrorString(result) << std::endl;
+  std::vector<AlphaBetaProblem> chunk;
+  std::vector<AlphaBetaResult> results;
+  std::vector<int> answers;
+  std::vector<ShardRecord> records;
+  std::size_t verified = 0;
+  uint64_t diff = 0;
+  for (std::size_t first = 0; first < pending.size(); first += opt.checkpoint_every) {
+    const std::size_t n = std::min(opt.checkpoint_every, pending.size() - first);
+    chunk.clear();
+    for (std::size_t k = 0; k < n; ++k) chunk.push_back(problems[pending[first + k]]);
+    results.resize(n);
+    solve_problems(devices, escalation.get(), opt, cache, chunk.data(), results.data(), n);
+    for (std::size_t k = 0; k < n; ++k) {
+      AlphaBetaResult &result = results[k];
+      if (result.score <= chunk[k].alpha || result.score >= chunk[k].beta) result.move = 0;
+      if (opt.mode == "wld") result.score = (result.score > 0) - (result.score < 0);
     }
+    verified += verify_results(opt, chunk.data(), results.data(), n, pending.data() + first, answers, diff);
+    records.resize(n);
+    for (std::size_t k = 0; k < n; ++k) records[k] = (ShardRecord){pending[first + k], results[k], answers[k], 0};
+    if (!shard_file.append(records.data(), n)) return 1;
+    std::cerr << "checkpoint: " << shard_size - pending.size() + first + n << "/" << shard_size << std::endl;
   }
+  auto end = std::chrono::system_clock::now();
+  print_stats(devices, std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count());
+  print_escalation(escalation.get());
+  std::cerr << "verified: " << verified << std::endl;
+  std::cerr << "diff: " << diff << std::endl;
+  return 0;
+}
 
-  std::vector<int32_t> results(N);
-  for (cl_uint i = 0; i < num_devices; ++i) {
-    const size_t real_chunk_size = std::min(chunk_size, N - i * chunk_size);
-
-    result = clEnqueueReadBuffer(command_queues[i], mem_results[i], CL_TRUE, 0, sizeof(int32_t)*real_chunk_size, &results[i * chunk_size], 0, nullptr, nullptr);
-    if (result != CL_SUCCESS) {
-      std::cerr << "read buffer error: " << getErrorString(result) << std::endl;
+int main(int argc, char **argv) {
+  const Options opt = parse_options(argc, argv);
+  if (opt.args.size() != (opt.serve ? 0 : 2)) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (opt.mode != "exact" && opt.mode != "mtdf" && opt.mode != "wld" && opt.mode != "test") {
+    std::cerr << "unknown mode: " << opt.mode << std::endl;
+    return 1;
+  }
+  if (opt.ordering != "mobility" && opt.ordering != "pattern" && opt.ordering != "shallow") {
+    std::cerr << "unknown ordering: " << opt.ordering << std::endl;
+    return 1;
+  }
+  std::vector<short> pattern_weights;
+  if (!opt.eval_path.empty() && !load_pattern_weights(opt.eval_path, pattern_weights)) return 1;
+  if (opt.ordering == "pattern" && pattern_weights.empty()) {
+    std::cerr << "--ordering=pattern needs --eval=PATH" << std::endl;
+    return 1;
+  }
+  ShardSpec shard = {0, 0, false};
+  if (!opt.shard.empty()) {
+    if (!parse_shard(opt.shard, shard) || (opt.shard_by != "range" && opt.shard_by != "hash")) {
+      std::cerr << "bad shard: --shard=" << opt.shard << " --shard-by=" << opt.shard_by << std::endl;
+      return 1;
+    }
+    shard.by_hash = opt.shard_by == "hash";
+    if (opt.pipeline || opt.serve) {
+      std::cerr << "--shard does not support --pipeline or --serve" << std::endl;
+      return 1;
+    }
+  }
+  if (opt.pipeline || opt.serve) {
+    // the input is not known in advance, size the stacks for any position
+    const SolverConfig config = solver_config(opt, 64, pattern_weights);
+    std::vector<std::unique_ptr<Device>> devices = open_devices(opt, config);
+    if (devices.empty()) {
+      std::cerr << "no device available" << std::endl;
+      return 1;
     }
+    std::unique_ptr<Device> escalation = open_escalation_device(opt);
+    if (opt.serve) return run_service(opt, devices, escalation.get());
+    return run_pipelined(opt, devices, escalation.get());
+  }
+  ProblemSet problem_set;
+  if (!problem_set.load(opt.args[0])) return 1;
+  // merge checks the shard files against the input as it was read
+  const ull input = shard.shards ? input_hash(problem_set.data(), problem_set.size()) : 0;
+  int alpha, beta;
+  if (mode_window(opt, alpha, beta)) problem_set.set_window(alpha, beta);
+  if (shard.shards) {
+    std::cerr << "N = " << problem_set.size() << std::endl;
+    return run_sharded(opt, shard, problem_set, input, pattern_weights);
+  }
+  const std::size_t N = problem_set.size();
+  const AlphaBetaProblem * const problems = problem_set.data();
+  std::cerr << "N = " << N << std::endl;
+
+  int max_empties = 0;
+  for (std::size_t i = 0; i < N; ++i) max_empties = std::max(max_empties, 64 - stones_count(problems[i].me, problems[i].op));
+  const SolverConfig config = solver_config(opt, max_empties, pattern_weights);
+  std::vector<std::unique_ptr<Device>> devices = open_devices(opt, config);
+  if (devices.empty()) {
+    std::cerr << "no device available" << std::endl;
+    return 1;
+  }
+  std::unique_ptr<Device> escalation = open_escalation_device(opt);
+  ResultCache cache;
+  if (!opt.cache_path.empty() && !cache.open(opt.cache_path, opt.cache_size)) return 1;
+  ResultSet result_set;
+  if (opt.binary_output) {
+    if (!result_set.create(opt.args[1], N)) return 1;
+  } else {
+    result_set.allocate(N);
+  }
+  AlphaBetaResult * const results = result_set.data();
+  auto start = std::chrono::system_clock::now();
+  std::cerr << "start" << std::endl;
+  solve_problems(devices, escalation.get(), opt, cache, problems, results, N);
+  std::vector<std::string> pv;
+  if (opt.pv > 0) {
+    const SolveFunction solve = [&](const AlphaBetaProblem *batch, AlphaBetaResult *batch_results, std::size_t count) {
+      run_solver(devices, escalation.get(), opt, batch, batch_results, count);
+    };
+    principal_variations(solve, problems, results, N, opt.pv, pv);
+  }
+  if (opt.mode == "wld") {
+    for (std::size_t i = 0; i < N; ++i) results[i].score = (results[i].score > 0) - (results[i].score < 0);
   }
   auto end = std::chrono::system_clock::now();
   double elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
-  std::cerr << "elapsed: " << elapsed << std::endl;
+  print_stats(devices, elapsed);
+  print_escalation(escalation.get());
+  if (!opt.report_path.empty()) {
+    std::ofstream report(opt.report_path);
+    write_report(report, (RunInfo){opt.backend, N, elapsed, stack_bytes_per_thread(config)}, devices, problems, results);
+  }
 
-  std::ofstream ofs(argv[2]);
-  ofs << N << '\n';
+  std::vector<int> answers;
   uint64_t diff = 0;
-  omp_lock_t write_lock;
-  omp_init_lock(&write_lock);
-#pragma omp parallel for
-  for (std::size_t i = 0; i < N; ++i) {
-    Search search = {Board(problems[i].me, problems[i].op)};
-    int answer = search.alpha_beta(-64, 64);
-    omp_set_lock(&write_lock);
-    ofs << board_str_vec[i] << ' ' << results[i] << ' ' << answer << '\n';
-    diff += abs(results[i] - answer);
-    omp_unset_lock(&write_lock);
+  std::cerr << "verified: " << verify_results(opt, problems, results, N, nullptr, answers, diff) << std::endl;
+  if (!opt.binary_output) {
+    write_results_text(opt.args[1], problems, results, answers.data(), opt.pv > 0 ? pv.data() : nullptr, N);
   }
   std::cerr << "diff: " << diff << std::endl;
 
-  for (cl_uint i = 0; i < num_devices; ++i) {
-    clReleaseKernel(kernels[i]);
-    clReleaseProgram(programs[i]);
-    clReleaseMemObject(mem_probs[i]);
-    clReleaseMemObject(mem_results[i]);
-    clReleaseMemObject(mem_ustacks[i]);
-    clReleaseMemObject(mem_lstacks[i]);
-    clReleaseMemObject(mem_numnodes[i]);
-    clReleaseCommandQueue(command_queues[i]);
-    clReleaseContext(contexts[i]);
-  }
-
   return 0;
 }
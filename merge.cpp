@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "problem_file.hpp"
+#include "shard.hpp"
+#include "pv.hpp"
+
+// Puts the shard files of sharded runs (solve --shard=K/N) of INPUT back
+// together into the output an unsharded run would have written, in input
+// order. Fails if a problem is in none of the shard files.
+//   merge [--output-format=text|binary] [--best-move] INPUT OUTPUT SHARD_FILE...
+
+namespace {
+
+void usage(const char *prog) {
+  std::cerr << "usage: " << prog << " [--output-format=text|binary] [--best-move] INPUT OUTPUT SHARD_FILE..." << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bool binary = false;
+  bool best_move = false;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--output-format=binary") {
+      binary = true;
+    } else if (arg == "--output-format=text") {
+      binary = false;
+    } else if (arg == "--best-move") {
+      best_move = true;
+    } else {
+      args.push_back(arg);
+    }
+  }
+  if (args.size() < 3) {
+    usage(argv[0]);
+    return 1;
+  }
+  ProblemSet problems;
+  if (!problems.load(args[0])) return 1;
+  const std::size_t N = problems.size();
+  const ull input = input_hash(problems.data(), N);
+  std::vector<AlphaBetaResult> results(N);
+  std::vector<int> answers(N, no_answer);
+  std::vector<bool> covered(N, false);
+  std::vector<bool> shard_seen;
+  ull shards = 0, by_hash = 0;
+  for (std::size_t f = 2; f < args.size(); ++f) {
+    ShardHeader header;
+    std::vector<ShardRecord> records;
+    if (!read_shard_file(args[f], header, records)) return 1;
+    if (header.input != input || header.total != N) {
+      std::cerr << args[f] << ": shard of another input than " << args[0] << std::endl;
+      return 1;
+    }
+    if (shard_seen.empty()) {
+      shards = header.shards;
+      by_hash = header.by_hash;
+      shard_seen.assign(shards, false);
+    } else if (header.shards != shards || header.by_hash != by_hash) {
+      std::cerr << args[f] << ": sharded differently from " << args[2] << std::endl;
+      return 1;
+    }
+    if (header.shard >= shards || shard_seen[header.shard]) {
+      std::cerr << args[f] << ": shard " << header.shard << "/" << shards << " given twice or out of range" << std::endl;
+      return 1;
+    }
+    shard_seen[header.shard] = true;
+    for (const ShardRecord &record : records) {
+      if (record.index >= N) {
+        std::cerr << args[f] << ": problem " << record.index << " out of range" << std::endl;
+        return 1;
+      }
+      results[record.index] = record.result;
+      answers[record.index] = record.answer;
+      covered[record.index] = true;
+    }
+  }
+  const std::size_t missing = std::count(covered.begin(), covered.end(), false);
+  if (missing) {
+    std::cerr << missing << " of " << N << " problems missing; shards not given:";
+    for (ull s = 0; s < shards; ++s) {
+      if (!shard_seen[s]) std::cerr << ' ' << s;
+    }
+    std::cerr << " (or not finished)" << std::endl;
+    return 1;
+  }
+  if (binary) {
+    ResultSet result_set;
+    if (!result_set.create(args[1], N)) return 1;
+    std::memcpy(result_set.data(), results.data(), N * sizeof(AlphaBetaResult));
+    return 0;
+  }
+  std::vector<std::string> moves;
+  if (best_move) {
+    moves.resize(N);
+    for (std::size_t i = 0; i < N; ++i) {
+      if (results[i].move) moves[i] = move_name(results[i].move);
+    }
+  }
+  return write_results_text(args[1], problems.data(), results.data(), answers.data(),
+      best_move ? moves.data() : nullptr, N) ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include "mtdf.hpp"
+
+namespace {
+
+// first guess for every problem
+constexpr int initial_guess = 0;
+
+// Final scores are even, so a probe at an odd threshold t with window
+// (t - 1, t + 1) always decides score < t or score > t.
+struct Probe {
+  int lower;      // score >= lower
+  int upper;      // score <= upper
+  int threshold;  // odd, lower < threshold < upper
+  int step;       // distance of the next threshold from the bound, even
+  int direction;  // +1 after a fail high, -1 after a fail low, 0 at first
+  ull nodes;
+  unsigned char move; // of the last fail high, which proves lower
+};
+
+bool resolved(const Probe &probe, const AlphaBetaProblem &problem) {
+  return probe.lower >= probe.upper || probe.upper <= problem.alpha || probe.lower >= problem.beta;
+}
+
+void update(Probe &probe, int score) {
+  const int t = probe.threshold;
+  const int direction = score > t ? 1 : -1;
+  probe.step = direction == probe.direction ? probe.step * 2 : 2;
+  probe.direction = direction;
+  if (direction > 0) {
+    probe.lower = std::max(probe.lower, score);
+    probe.threshold = std::min(probe.lower + probe.step - 1, probe.upper - 1);
+  } else {
+    probe.upper = std::min(probe.upper, t - 1);
+    probe.threshold = std::max(probe.upper - probe.step + 1, probe.lower + 1);
+  }
+}
+
+void solve_round(const std::vector<std::unique_ptr<Device>> &devices,
+    const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count,
+    const DispatchOptions &dispatch, const SplitOptions &split) {
+  if (split.depth > 0) {
+    solve_split(devices, problems, results, count, dispatch, split);
+  } else {
+    solve_all(devices, problems, results, count, dispatch);
+  }
+}
+
+} // namespace
+
+int solve_mtdf(const std::vector<std::unique_ptr<Device>> &devices,
+    const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count,
+    const DispatchOptions &dispatch, const SplitOptions &split) {
+  std::vector<Probe> probes(count, (Probe){-64, 64, initial_guess + 1, 2, 0, 0, 0});
+  std::vector<std::size_t> pending;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (!resolved(probes[i], problems[i])) pending.push_back(i);
+  }
+  int rounds = 0;
+  std::vector<AlphaBetaProblem> batch;
+  std::vector<AlphaBetaResult> batch_results;
+  for (; !pending.empty(); ++rounds) {
+    batch.clear();
+    for (std::size_t i : pending) {
+      const int t = probes[i].threshold;
+      batch.push_back(AlphaBetaProblem(problems[i].me, problems[i].op, t - 1, t + 1));
+    }
+    batch_results.resize(batch.size());
+    solve_round(devices, batch.data(), batch_results.data(), batch.size(), dispatch, split);
+    std::size_t next = 0;
+    for (std::size_t k = 0; k < pending.size(); ++k) {
+      const std::size_t i = pending[k];
+      probes[i].nodes += batch_results[k].nodes;
+      if (batch_results[k].score > probes[i].threshold) probes[i].move = batch_results[k].move;
+      update(probes[i], batch_results[k].score);
+      if (!resolved(probes[i], problems[i])) pending[next++] = i;
+    }
+    pending.resize(next);
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    const Probe &probe = probes[i];
+    const int score = probe.upper <= problems[i].alpha ? probe.upper : probe.lower;
+    results[i] = (AlphaBetaResult){probe.nodes, score, false, 0, probe.move};
+  }
+  return rounds;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "device.hpp"
+#include "dispatch.hpp"
+#include "split.hpp"
+
+// Solve problems[0, count) by rounds of null-window probes (MTD(f)). Each
+// round sends one probe per unresolved problem to the devices as a single
+// batch and narrows that problem's bounds with the result; the next probe
+// starts from the new bound, with steps doubling while the score keeps
+// moving the same way. Scores outside a problem's (alpha, beta) are
+// returned as bounds, like a full search of that window. results[i].nodes
+// is the sum over all probes. Returns the number of rounds.
+int solve_mtdf(const std::vector<std::unique_ptr<Device>> &devices,
+    const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count,
+    const DispatchOptions &dispatch, const SplitOptions &split);
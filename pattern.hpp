@@ -0,0 +1,91 @@
+#pragma once
+#include "types.hpp"
+#include "board.hpp"
+
+// Pattern evaluation for ordering upper nodes. A pattern instance is a list
+// of squares read as base-3 digits (0 empty, 1 me, 2 op); the instances
+// that are images of each other under the board symmetries share one table
+// of weights. A further table is indexed by the mover's mobility. The sum
+// is in 1/pattern_scale discs from the mover's side.
+
+constexpr int pattern_scale = 32;
+constexpr int pattern_instances = 10;
+constexpr int pattern_max_squares = 9;
+
+// edges, corner 3x3 blocks, diagonals; -1 ends a shorter instance
+constexpr signed char pattern_squares[pattern_instances][pattern_max_squares] = {
+  {0, 1, 2, 3, 4, 5, 6, 7, -1},
+  {56, 57, 58, 59, 60, 61, 62, 63, -1},
+  {0, 8, 16, 24, 32, 40, 48, 56, -1},
+  {7, 15, 23, 31, 39, 47, 55, 63, -1},
+  {0, 1, 2, 8, 9, 10, 16, 17, 18},
+  {7, 6, 5, 15, 14, 13, 23, 22, 21},
+  {56, 57, 58, 48, 49, 50, 40, 41, 42},
+  {63, 62, 61, 55, 54, 53, 47, 46, 45},
+  {0, 9, 18, 27, 36, 45, 54, 63, -1},
+  {7, 14, 21, 28, 35, 42, 49, 56, -1},
+};
+
+constexpr int edge_weights = 6561;     // 3^8
+constexpr int corner_weights = 19683;  // 3^9
+constexpr int diagonal_weights = 6561; // 3^8
+constexpr int mobility_offset = edge_weights + corner_weights + diagonal_weights;
+constexpr int pattern_weight_count = mobility_offset + 64;
+
+constexpr int pattern_offsets[pattern_instances] = {
+  0, 0, 0, 0,
+  edge_weights, edge_weights, edge_weights, edge_weights,
+  edge_weights + corner_weights, edge_weights + corner_weights,
+};
+
+inline int pattern_index(ull me, ull op, int instance) {
+  int index = 0;
+  for (int i = 0; i < pattern_max_squares && pattern_squares[instance][i] >= 0; ++i) {
+    const int pos = pattern_squares[instance][i];
+    index = index * 3 + (int)((me >> pos) & 1) + 2 * (int)((op >> pos) & 1);
+  }
+  return pattern_offsets[instance] + index;
+}
+
+inline int pattern_eval(ull me, ull op, const short *weights) {
+  int score = weights[mobility_offset + mobility_count(me, op)];
+  for (int k = 0; k < pattern_instances; ++k) score += weights[pattern_index(me, op, k)];
+  return score;
+}
+
+// Upper node ordering: by the opponent's mobility after the move (the
+// default), by the pattern evaluation of the position after it, and/or by
+// a one-ply search below it (the opponent's best reply).
+constexpr int ordering_pattern = 1;
+constexpr int ordering_shallow = 2;
+
+struct Ordering {
+  int mode;             // ordering_* bits, 0: mobility
+  int min_empties;      // nodes with fewer empties are ordered by mobility
+  const short *weights; // pattern_weight_count weights if mode has ordering_pattern
+};
+
+// static value for the mover: the pattern evaluation with a disc per legal
+// move on top (fewest replies first still matters most), or else the
+// mobility difference
+inline int ordering_eval(ull me, ull op, const Ordering &ordering) {
+  if (ordering.mode & ordering_pattern) {
+    return pattern_eval(me, op, ordering.weights) + mobility_count(me, op) * pattern_scale;
+  }
+  return (mobility_count(me, op) - mobility_count(op, me)) * pattern_scale;
+}
+
+// key of the position after a move, from the side to move there: smaller
+// is better for the player who made the move
+inline int ordering_key(ull me, ull op, const Ordering &ordering) {
+  if (!(ordering.mode & ordering_shallow)) return ordering_eval(me, op, ordering);
+  int best = -64 * pattern_scale - 1;
+  for (ull bits = mobility(me, op); bits; bits &= bits - 1) {
+    const ull bit = bits & -bits;
+    const ull flip_bits = flip(me, op, popcnt(bit - 1));
+    const int value = -ordering_eval(op ^ flip_bits, (me ^ flip_bits) | bit, ordering);
+    if (value > best) best = value;
+  }
+  if (best < -64 * pattern_scale) return -ordering_eval(op, me, ordering); // pass
+  return best;
+}
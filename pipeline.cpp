@@ -0,0 +1,201 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include "pipeline.hpp"
+#include "dispatch.hpp"
+#include "pv.hpp"
+#include "host_solver.hpp"
+
+namespace {
+
+struct Batch {
+  std::size_t seq;   // position in the input, in batches
+  std::size_t first; // index of problems[0] in the input
+  std::vector<AlphaBetaProblem> problems;
+  std::vector<AlphaBetaResult> results;
+  std::vector<int> answers;
+};
+
+// blocking FIFO between pipeline stages; pop returns null once the queue
+// is closed and drained, try_pop whenever it is empty
+class Channel {
+ public:
+  Channel() : closed(false) {}
+  void push(Batch *batch) {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(batch);
+    cond.notify_one();
+  }
+  Batch *pop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this] { return closed || !queue.empty(); });
+    if (queue.empty()) return nullptr;
+    Batch *batch = queue.front();
+    queue.pop_front();
+    return batch;
+  }
+  Batch *try_pop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.empty()) return nullptr;
+    Batch *batch = queue.front();
+    queue.pop_front();
+    return batch;
+  }
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    cond.notify_all();
+  }
+ private:
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::deque<Batch *> queue;
+  bool closed;
+};
+
+void read_batches(ProblemReader &reader, const PipelineOptions &options,
+    Channel &free_batches, Channel &ready) {
+  std::size_t first = 0;
+  for (std::size_t seq = 0;; ++seq) {
+    Batch *batch = free_batches.pop();
+    if (!batch) break;
+    batch->problems.resize(options.batch_size, AlphaBetaProblem(0, 0));
+    const std::size_t n = reader.read(batch->problems.data(), options.batch_size);
+    if (n == 0) break;
+    batch->problems.resize(n, AlphaBetaProblem(0, 0));
+    if (options.set_window) {
+      for (AlphaBetaProblem &problem : batch->problems) {
+        problem.alpha = options.alpha;
+        problem.beta = options.beta;
+      }
+    }
+    batch->results.resize(n);
+    batch->seq = seq;
+    batch->first = first;
+    first += n;
+    ready.push(batch);
+  }
+  ready.close();
+}
+
+void run_device(Device *device, Channel &ready, Channel &done) {
+  std::deque<Batch *> in_flight;
+  const std::size_t depth = std::max<std::size_t>(1, device->pipeline_depth());
+  auto busy_since = std::chrono::steady_clock::now();
+  auto complete = [&] {
+    device->finish();
+    Batch *batch = in_flight.front();
+    in_flight.pop_front();
+    const auto now = std::chrono::steady_clock::now();
+    device->add_usage(std::chrono::duration<double>(now - busy_since).count(), batch->problems.size());
+    busy_since = now;
+    done.push(batch);
+  };
+  while (true) {
+    // a batch held in flight while nothing else arrives may be the one the
+    // writer waits for while the other devices fill the pool with later
+    // ones, so it is completed instead of blocking on ready
+    Batch *batch = in_flight.empty() ? ready.pop() : ready.try_pop();
+    if (!batch) {
+      if (in_flight.empty()) break;
+      complete();
+      continue;
+    }
+    if (in_flight.empty()) busy_since = std::chrono::steady_clock::now();
+    device->submit(batch->problems.data(), batch->results.data(), batch->problems.size());
+    in_flight.push_back(batch);
+    if (in_flight.size() >= depth) complete();
+  }
+}
+
+void verify(Batch &batch, const PipelineOptions &options, PipelineStats &stats) {
+  batch.answers.assign(batch.problems.size(), no_answer);
+  std::vector<std::size_t> sample;
+  for (std::size_t i = 0; i < batch.problems.size(); ++i) {
+    if (in_verify_sample(batch.first + i, options.verify_percent)) sample.push_back(i);
+  }
+#pragma omp parallel for schedule(dynamic)
+  for (std::size_t k = 0; k < sample.size(); ++k) {
+    const AlphaBetaProblem &problem = batch.problems[sample[k]];
+    HostSolver solver;
+    batch.answers[sample[k]] = solver.solve(problem.me, problem.op);
+  }
+  for (std::size_t i : sample) {
+    const int score = batch.results[i].score;
+    if (!consistent(batch.problems[i], score, batch.answers[i])) stats.diff += std::abs(score - batch.answers[i]);
+  }
+  stats.verified += sample.size();
+}
+
+} // namespace
+
+bool in_verify_sample(std::size_t index, int verify_percent) {
+  return (index * UINT64_C(0x9E3779B97F4A7C15) >> 32) % 100 < (ull)verify_percent;
+}
+
+bool solve_pipelined(const std::vector<std::unique_ptr<Device>> &devices,
+    ProblemReader &reader, ResultWriter &writer, const PipelineOptions &options,
+    PipelineStats &stats) {
+  stats = (PipelineStats){0, 0, 0};
+  // enough buffers for every device's batches in flight, one more waiting
+  // for each device, and one each being read and written
+  std::size_t pool_size = 2;
+  for (const auto &device : devices) pool_size += std::max<std::size_t>(1, device->pipeline_depth()) + 1;
+  std::vector<Batch> pool(pool_size);
+  Channel free_batches, ready, done;
+  for (Batch &batch : pool) free_batches.push(&batch);
+
+  std::thread reader_thread(read_batches, std::ref(reader), std::cref(options),
+      std::ref(free_batches), std::ref(ready));
+  std::atomic<std::size_t> running(devices.size());
+  std::vector<std::thread> device_threads;
+  for (const auto &device : devices) {
+    Device *ptr = device.get();
+    device_threads.emplace_back([ptr, &ready, &done, &running] {
+      run_device(ptr, ready, done);
+      if (--running == 0) done.close();
+    });
+  }
+
+  // write finished batches in input order
+  bool ok = true;
+  std::vector<std::string> moves;
+  std::map<std::size_t, Batch *> finished;
+  std::size_t next_seq = 0;
+  while (Batch *batch = done.pop()) {
+    finished[batch->seq] = batch;
+    for (auto it = finished.find(next_seq); it != finished.end(); it = finished.find(++next_seq)) {
+      Batch &ready_batch = *it->second;
+      if (options.escalation) {
+        escalate(*options.escalation, ready_batch.problems.data(), ready_batch.results.data(),
+            ready_batch.problems.size());
+      }
+      if (options.best_move) {
+        moves.assign(ready_batch.problems.size(), std::string());
+        for (std::size_t i = 0; i < moves.size(); ++i) {
+          const AlphaBetaProblem &problem = ready_batch.problems[i];
+          const AlphaBetaResult &res = ready_batch.results[i];
+          if (res.score > problem.alpha && res.score < problem.beta && res.move) moves[i] = move_name(res.move);
+        }
+      }
+      if (options.sign_scores) {
+        for (AlphaBetaResult &res : ready_batch.results) res.score = (res.score > 0) - (res.score < 0);
+      }
+      verify(ready_batch, options, stats);
+      ok = writer.write(ready_batch.problems.data(), ready_batch.results.data(),
+          ready_batch.answers.data(), options.best_move ? moves.data() : nullptr, ready_batch.problems.size()) && ok;
+      stats.problems += ready_batch.problems.size();
+      finished.erase(it);
+      free_batches.push(&ready_batch);
+    }
+  }
+  free_batches.close();
+  reader_thread.join();
+  for (auto &thread : device_threads) thread.join();
+  return ok && stats.problems == reader.size();
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "device.hpp"
+#include "problem_file.hpp"
+
+struct PipelineOptions {
+  std::size_t batch_size;
+  bool set_window;    // search every problem with (alpha, beta)
+  int alpha;
+  int beta;
+  bool sign_scores;   // write scores as -1, 0, 1 (win/loss/draw)
+  int verify_percent;
+  Device *escalation; // re-solves problems that ran out of node budget, or null
+  bool best_move;     // write the best move of exact scores next to them
+};
+
+struct PipelineStats {
+  std::size_t problems;
+  std::size_t verified;
+  ull diff;
+};
+
+// whether problem index belongs to the deterministic verification sample
+bool in_verify_sample(std::size_t index, int verify_percent);
+
+// Streams the problems of reader through the devices in batches and writes
+// the results to writer in input order. Parsing the next batches, the
+// batches in flight on every device (up to pipeline_depth() each, through
+// Device::submit/finish) and verifying and writing finished batches all
+// overlap; a fixed pool of batch buffers bounds the memory used. Suspended
+// problems are escalated batch by batch before they are written.
+bool solve_pipelined(const std::vector<std::unique_ptr<Device>> &devices,
+    ProblemReader &reader, ResultWriter &writer, const PipelineOptions &options,
+    PipelineStats &stats);
@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "problem_file.hpp"
+#include "to_board.hpp"
+
+namespace {
+
+constexpr char problem_magic[8] = {'P', 'Z', 'O', 'T', 'H', 'P', 'R', '1'};
+constexpr char result_magic[8] = {'P', 'Z', 'O', 'T', 'H', 'R', 'S', '1'};
+constexpr char weights_magic[8] = {'P', 'Z', 'O', 'T', 'H', 'E', 'V', '1'};
+constexpr std::size_t board_str_size = 16;
+constexpr std::size_t codec_chunk = 1024; // records per toBoardBatch/fromBoardBatch call
+
+bool is_space(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool write_binary(const std::string &path, const char *magic, const void *records, std::size_t size, std::size_t count) {
+  MappedFile file;
+  if (!file.create(path, sizeof(FileHeader) + size * count)) return false;
+  FileHeader header;
+  std::memcpy(header.magic, magic, sizeof(header.magic));
+  header.count = count;
+  std::memcpy(file.data(), &header, sizeof(header));
+  std::memcpy(file.data() + sizeof(header), records, size * count);
+  return true;
+}
+
+// "N" at the start of the text format
+std::size_t parse_count(const char *&ptr, const char *end) {
+  while (ptr < end && is_space(*ptr)) ++ptr;
+  std::size_t n = 0;
+  for (; ptr < end && *ptr >= '0' && *ptr <= '9'; ++ptr) n = n * 10 + (*ptr - '0');
+  return n;
+}
+
+// parses count boards at ptr into problems, in chunks of codec_chunk
+bool parse_boards(const char *&ptr, const char *end, AlphaBetaProblem *problems, std::size_t count) {
+  std::vector<char> chunk(codec_chunk * board_str_size);
+  std::vector<Board> boards(codec_chunk, Board(0, 0));
+  for (std::size_t first = 0; first < count; first += codec_chunk) {
+    const std::size_t size = std::min(codec_chunk, count - first);
+    for (std::size_t i = 0; i < size; ++i) {
+      while (ptr < end && is_space(*ptr)) ++ptr;
+      if (end - ptr < (std::ptrdiff_t)board_str_size) {
+        std::cerr << "input ended after " << first + i << " boards" << std::endl;
+        return false;
+      }
+      std::memcpy(chunk.data() + i * board_str_size, ptr, board_str_size);
+      ptr += board_str_size;
+    }
+    toBoardBatch(chunk.data(), boards.data(), size);
+    for (std::size_t i = 0; i < size; ++i) problems[first + i] = AlphaBetaProblem(boards[i].me, boards[i].op);
+  }
+  return true;
+}
+
+// one "board score [move] [answer] nodes" line per problem, or just the board
+void write_text_records(std::ostream &os, const AlphaBetaProblem *problems,
+    const AlphaBetaResult *results, const int *answers, const std::string *moves, std::size_t count) {
+  std::vector<char> chunk(codec_chunk * board_str_size);
+  std::vector<Board> boards(codec_chunk, Board(0, 0));
+  for (std::size_t first = 0; first < count; first += codec_chunk) {
+    const std::size_t size = std::min(codec_chunk, count - first);
+    for (std::size_t i = 0; i < size; ++i) {
+      boards[i] = Board(problems[first + i].me, problems[first + i].op);
+    }
+    fromBoardBatch(boards.data(), chunk.data(), size);
+    for (std::size_t i = 0; i < size; ++i) {
+      os.write(chunk.data() + i * board_str_size, board_str_size);
+      if (results) {
+        os << ' ' << results[first + i].score;
+        if (moves) os << ' ' << (moves[first + i].empty() ? "-" : moves[first + i]);
+        if (answers && answers[first + i] == no_answer) os << " -";
+        else if (answers) os << ' ' << answers[first + i];
+        os << ' ' << results[first + i].nodes;
+      }
+      os << '\n';
+    }
+  }
+}
+
+} // namespace
+
+bool MappedFile::open_read(const std::string &path) {
+  close();
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "cannot open " << path << std::endl;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    ::close(fd);
+    return false;
+  }
+  length = st.st_size;
+  if (length) {
+    addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      std::cerr << "cannot map " << path << std::endl;
+      addr = nullptr;
+      length = 0;
+      ::close(fd);
+      return false;
+    }
+    madvise(addr, length, MADV_SEQUENTIAL);
+  }
+  ::close(fd);
+  return true;
+}
+
+bool MappedFile::open_write(const std::string &path) {
+  close();
+  const int fd = ::open(path.c_str(), O_RDWR);
+  if (fd < 0) {
+    std::cerr << "cannot open " << path << std::endl;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    ::close(fd);
+    return false;
+  }
+  length = st.st_size;
+  if (length) {
+    addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      std::cerr << "cannot map " << path << std::endl;
+      addr = nullptr;
+      length = 0;
+      ::close(fd);
+      return false;
+    }
+  }
+  ::close(fd);
+  return true;
+}
+
+bool MappedFile::create(const std::string &path, std::size_t size) {
+  close();
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    std::cerr << "cannot create " << path << std::endl;
+    return false;
+  }
+  if (ftruncate(fd, size) < 0) {
+    std::cerr << "cannot resize " << path << std::endl;
+    ::close(fd);
+    return false;
+  }
+  length = size;
+  if (length) {
+    addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      std::cerr << "cannot map " << path << std::endl;
+      addr = nullptr;
+      length = 0;
+      ::close(fd);
+      return false;
+    }
+  }
+  ::close(fd);
+  return true;
+}
+
+void MappedFile::close() {
+  if (addr) munmap(addr, length);
+  addr = nullptr;
+  length = 0;
+}
+
+bool ProblemSet::load(const std::string &path) {
+  if (!file.open_read(path)) return false;
+  FileHeader header;
+  if (file.size() < sizeof(header) || std::memcmp(file.data(), problem_magic, sizeof(problem_magic)) != 0) {
+    return load_text();
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (header.count > (file.size() - sizeof(header)) / sizeof(AlphaBetaProblem)) {
+    std::cerr << path << ": truncated problem file" << std::endl;
+    return false;
+  }
+  problems = reinterpret_cast<AlphaBetaProblem *>(file.data() + sizeof(header));
+  count = header.count;
+  return true;
+}
+
+// "N" followed by N base-81 boards separated by whitespace
+bool ProblemSet::load_text() {
+  const char *ptr = file.data();
+  const char * const end = ptr + file.size();
+  const std::size_t n = parse_count(ptr, end);
+  owned.assign(n, AlphaBetaProblem(0, 0));
+  if (!parse_boards(ptr, end, owned.data(), n)) return false;
+  file.close();
+  problems = owned.data();
+  count = owned.size();
+  return true;
+}
+
+// a mapped problem file is copy-on-write, so this never changes the file
+void ProblemSet::set_window(int alpha, int beta) {
+  for (std::size_t i = 0; i < count; ++i) {
+    problems[i].alpha = alpha;
+    problems[i].beta = beta;
+  }
+}
+
+void ResultSet::allocate(std::size_t n) {
+  file.close();
+  owned.assign(n, (AlphaBetaResult){0, 0});
+  results = owned.data();
+  count = n;
+}
+
+bool ResultSet::create(const std::string &path, std::size_t n) {
+  owned.clear();
+  if (!file.create(path, sizeof(FileHeader) + sizeof(AlphaBetaResult) * n)) return false;
+  FileHeader header;
+  std::memcpy(header.magic, result_magic, sizeof(header.magic));
+  header.count = n;
+  std::memcpy(file.data(), &header, sizeof(header));
+  results = reinterpret_cast<AlphaBetaResult *>(file.data() + sizeof(header));
+  count = n;
+  return true;
+}
+
+bool ResultSet::load(const std::string &path) {
+  owned.clear();
+  if (!file.open_read(path)) return false;
+  FileHeader header;
+  if (file.size() < sizeof(header) || std::memcmp(file.data(), result_magic, sizeof(result_magic)) != 0) {
+    std::cerr << path << ": not a result file" << std::endl;
+    return false;
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (header.count > (file.size() - sizeof(header)) / sizeof(AlphaBetaResult)) {
+    std::cerr << path << ": truncated result file" << std::endl;
+    return false;
+  }
+  results = reinterpret_cast<AlphaBetaResult *>(file.data() + sizeof(header));
+  count = header.count;
+  return true;
+}
+
+bool load_pattern_weights(const std::string &path, std::vector<short> &weights) {
+  MappedFile file;
+  if (!file.open_read(path)) return false;
+  FileHeader header;
+  if (file.size() < sizeof(header) || std::memcmp(file.data(), weights_magic, sizeof(weights_magic)) != 0) {
+    std::cerr << path << ": not a pattern weight file" << std::endl;
+    return false;
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (header.count != pattern_weight_count || file.size() < sizeof(header) + sizeof(short) * header.count) {
+    std::cerr << path << ": expected " << pattern_weight_count << " weights" << std::endl;
+    return false;
+  }
+  weights.resize(header.count);
+  std::memcpy(weights.data(), file.data() + sizeof(header), sizeof(short) * header.count);
+  return true;
+}
+
+bool write_pattern_weights(const std::string &path, const std::vector<short> &weights) {
+  return write_binary(path, weights_magic, weights.data(), sizeof(short), weights.size());
+}
+
+bool write_problems_binary(const std::string &path, const AlphaBetaProblem *problems, std::size_t count) {
+  return write_binary(path, problem_magic, problems, sizeof(AlphaBetaProblem), count);
+}
+
+bool write_problems_text(const std::string &path, const AlphaBetaProblem *problems, std::size_t count) {
+  return write_results_text(path, problems, nullptr, nullptr, nullptr, count);
+}
+
+bool write_results_text(const std::string &path, const AlphaBetaProblem *problems,
+    const AlphaBetaResult *results, const int *answers, const std::string *moves, std::size_t count) {
+  std::ofstream ofs(path);
+  if (!ofs) {
+    std::cerr << "cannot create " << path << std::endl;
+    return false;
+  }
+  ofs << count << '\n';
+  write_text_records(ofs, problems, results, answers, moves, count);
+  return bool(ofs);
+}
+
+bool ProblemReader::open(const std::string &path) {
+  if (!file.open_read(path)) return false;
+  ptr = file.data();
+  end = ptr + file.size();
+  next = 0;
+  binary = file.size() >= sizeof(FileHeader) && std::memcmp(ptr, problem_magic, sizeof(problem_magic)) == 0;
+  if (binary) {
+    FileHeader header;
+    std::memcpy(&header, ptr, sizeof(header));
+    if (header.count > (file.size() - sizeof(header)) / sizeof(AlphaBetaProblem)) {
+      std::cerr << path << ": truncated problem file" << std::endl;
+      return false;
+    }
+    count = header.count;
+    ptr += sizeof(header);
+  } else {
+    count = parse_count(ptr, end);
+  }
+  return true;
+}
+
+std::size_t ProblemReader::read(AlphaBetaProblem *problems, std::size_t max) {
+  const std::size_t n = std::min(max, count - next);
+  if (binary) {
+    std::memcpy(problems, ptr, sizeof(AlphaBetaProblem) * n);
+    ptr += sizeof(AlphaBetaProblem) * n;
+  } else if (!parse_boards(ptr, end, problems, n)) {
+    count = next;
+    return 0;
+  }
+  next += n;
+  return n;
+}
+
+bool ResultWriter::open(const std::string &path, std::size_t n, bool binary_output) {
+  binary = binary_output;
+  count = n;
+  written = 0;
+  if (binary) {
+    if (!file.create(path, sizeof(FileHeader) + sizeof(AlphaBetaResult) * n)) return false;
+    FileHeader header;
+    std::memcpy(header.magic, result_magic, sizeof(header.magic));
+    header.count = n;
+    std::memcpy(file.data(), &header, sizeof(header));
+    return true;
+  }
+  ofs.open(path);
+  if (!ofs) {
+    std::cerr << "cannot create " << path << std::endl;
+    return false;
+  }
+  ofs << n << '\n';
+  return true;
+}
+
+bool ResultWriter::write(const AlphaBetaProblem *problems, const AlphaBetaResult *results,
+    const int *answers, const std::string *moves, std::size_t n) {
+  n = std::min(n, count - written);
+  if (binary) {
+    std::memcpy(file.data() + sizeof(FileHeader) + sizeof(AlphaBetaResult) * written,
+        results, sizeof(AlphaBetaResult) * n);
+  } else {
+    write_text_records(ofs, problems, results, answers, moves, n);
+  }
+  written += n;
+  return binary || bool(ofs);
+}
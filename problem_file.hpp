@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "solver.hpp"
+
+// Binary problem and result files are a 16-byte header followed by records
+// laid out exactly like AlphaBetaProblem / AlphaBetaResult, so a mapped file
+// is handed to the devices without copying.
+struct FileHeader {
+  char magic[8];
+  ull count;
+};
+
+class MappedFile {
+ public:
+  MappedFile() : addr(nullptr), length(0) {}
+  MappedFile(const MappedFile &) = delete;
+  MappedFile& operator=(const MappedFile &) = delete;
+  ~MappedFile() { close(); }
+  // maps path copy-on-write: writes through data() never reach the file
+  bool open_read(const std::string &path);
+  // maps an existing path writable, writes go to the file
+  bool open_write(const std::string &path);
+  // creates (or truncates) path with size bytes and maps it writable
+  bool create(const std::string &path, std::size_t size);
+  void close();
+  char *data() const { return static_cast<char *>(addr); }
+  std::size_t size() const { return length; }
+ private:
+  void *addr;
+  std::size_t length;
+};
+
+class ProblemSet {
+ public:
+  ProblemSet() : problems(nullptr), count(0) {}
+  // reads a binary problem file, or the base-81 text format otherwise
+  bool load(const std::string &path);
+  // search every problem with window (alpha, beta) instead of the loaded one
+  void set_window(int alpha, int beta);
+  const AlphaBetaProblem *data() const { return problems; }
+  std::size_t size() const { return count; }
+ private:
+  bool load_text();
+  MappedFile file;
+  std::vector<AlphaBetaProblem> owned;
+  AlphaBetaProblem *problems;
+  std::size_t count;
+};
+
+// Reads a problem file a batch at a time, parsing the text format as it
+// goes, so that a file larger than memory can be streamed.
+class ProblemReader {
+ public:
+  ProblemReader() : ptr(nullptr), end(nullptr), binary(false), count(0), next(0) {}
+  bool open(const std::string &path);
+  // number of problems in the file
+  std::size_t size() const { return count; }
+  // reads up to max problems, returns how many were read (0 at the end)
+  std::size_t read(AlphaBetaProblem *problems, std::size_t max);
+ private:
+  MappedFile file;
+  const char *ptr;
+  const char *end;
+  bool binary;
+  std::size_t count;
+  std::size_t next;
+};
+
+class ResultSet {
+ public:
+  ResultSet() : results(nullptr), count(0) {}
+  void allocate(std::size_t count);
+  // results are written straight into the binary result file at path
+  bool create(const std::string &path, std::size_t count);
+  // reads a binary result file
+  bool load(const std::string &path);
+  AlphaBetaResult *data() { return results; }
+  const AlphaBetaResult *data() const { return results; }
+  std::size_t size() const { return count; }
+ private:
+  MappedFile file;
+  std::vector<AlphaBetaResult> owned;
+  AlphaBetaResult *results;
+  std::size_t count;
+};
+
+// Writes results in input order as they become available, in the text
+// format of write_results_text or as a binary result file.
+class ResultWriter {
+ public:
+  ResultWriter() : binary(false), count(0), written(0) {}
+  bool open(const std::string &path, std::size_t count, bool binary);
+  // appends the next n results; answers and moves may be null
+  bool write(const AlphaBetaProblem *problems, const AlphaBetaResult *results,
+      const int *answers, const std::string *moves, std::size_t n);
+ private:
+  MappedFile file;
+  std::ofstream ofs;
+  bool binary;
+  std::size_t count;
+  std::size_t written;
+};
+
+// pattern_weight_count weights of pattern_eval after a FileHeader
+bool load_pattern_weights(const std::string &path, std::vector<short> &weights);
+bool write_pattern_weights(const std::string &path, const std::vector<short> &weights);
+
+bool write_problems_binary(const std::string &path, const AlphaBetaProblem *problems, std::size_t count);
+bool write_problems_text(const std::string &path, const AlphaBetaProblem *problems, std::size_t count);
+// answers[i] for a problem that was not verified, written as "-"
+constexpr int no_answer = 127;
+// one "board score [move] [answer] nodes" line per problem, move being the
+// best move or variation ("-" if unknown); answers and moves may be null
+bool write_results_text(const std::string &path, const AlphaBetaProblem *problems,
+    const AlphaBetaResult *results, const int *answers, const std::string *moves, std::size_t count);
@@ -0,0 +1,83 @@
+#include "pv.hpp"
+#include "board.hpp"
+
+namespace {
+
+// the position at the end of a variation so far
+struct Line {
+  std::size_t index;
+  ull me, op;
+  int score; // exact, for the side to move
+  int plies; // moves in the variation, passes included
+};
+
+void play(Line &line, int pos, std::string &pv) {
+  const ull flip_bits = flip(line.me, line.op, pos);
+  const ull me = line.op ^ flip_bits;
+  line.op = (line.me ^ flip_bits) | (UINT64_C(1) << pos);
+  line.me = me;
+  line.score = -line.score;
+  ++line.plies;
+  pv += move_name(1 + pos);
+}
+
+// plays a forced pass; false if the game is over
+bool pass_if_forced(Line &line, std::string &pv) {
+  if (mobility(line.me, line.op)) return true;
+  if (!mobility(line.op, line.me)) return false;
+  std::swap(line.me, line.op);
+  line.score = -line.score;
+  ++line.plies;
+  pv += move_name(0);
+  return true;
+}
+
+} // namespace
+
+std::string move_name(unsigned char move) {
+  if (!move) return "--";
+  const int pos = move - 1;
+  return std::string(1, 'a' + pos % 8) + (char)('1' + pos / 8);
+}
+
+void principal_variations(const SolveFunction &solve, const AlphaBetaProblem *problems,
+    const AlphaBetaResult *results, std::size_t count, int length, std::vector<std::string> &pv) {
+  pv.assign(count, std::string());
+  std::vector<Line> lines;
+  for (std::size_t i = 0; i < count; ++i) {
+    const AlphaBetaProblem &problem = problems[i];
+    const int score = results[i].score;
+    if (score <= problem.alpha || score >= problem.beta) continue;
+    Line line = {i, problem.me, problem.op, score, 0};
+    if (!pass_if_forced(line, pv[i])) continue;
+    if (line.plies == 0) { // the root had a move
+      if (!results[i].move) continue;
+      play(line, results[i].move - 1, pv[i]);
+    }
+    lines.push_back(line);
+  }
+  std::vector<AlphaBetaProblem> batch;
+  std::vector<AlphaBetaResult> batch_results;
+  while (true) {
+    std::size_t next = 0;
+    for (Line &line : lines) {
+      if (line.plies < length && pass_if_forced(line, pv[line.index]) && line.plies < length) lines[next++] = line;
+    }
+    lines.resize(next);
+    if (lines.empty()) break;
+    batch.clear();
+    for (const Line &line : lines) {
+      batch.push_back(AlphaBetaProblem(line.me, line.op, line.score - 1, line.score + 1));
+    }
+    batch_results.resize(batch.size());
+    solve(batch.data(), batch_results.data(), batch.size());
+    next = 0;
+    for (std::size_t k = 0; k < lines.size(); ++k) {
+      Line &line = lines[k];
+      if (batch_results[k].score != line.score || !batch_results[k].move) continue;
+      play(line, batch_results[k].move - 1, pv[line.index]);
+      lines[next++] = line;
+    }
+    lines.resize(next);
+  }
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "dispatch.hpp"
+
+// square name of AlphaBetaResult::move, "a1" to "h8", or "--" for 0
+std::string move_name(unsigned char move);
+
+// Principal variations of up to length moves for the exact results[0,
+// count): the first move is results[i].move; each further one is the best
+// move of the position reached so far, found by solving it with a window
+// around its now known score. All problems of a ply go to solve as one
+// batch. pv[i] is the concatenated square names ("--" for a pass), empty
+// if results[i] is only a bound or its move is unknown.
+void principal_variations(const SolveFunction &solve, const AlphaBetaProblem *problems,
+    const AlphaBetaResult *results, std::size_t count, int length, std::vector<std::string> &pv);
@@ -0,0 +1,318 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <PZSDKHelper.h>
+#include <pzcl/pzcl_ocl_wrapper.h>
+#include "device.hpp"
+
+namespace {
+
+constexpr int MAX_BIN_SIZE = 1000000;
+constexpr size_t default_work_size = 8192; // threads per launch
+constexpr size_t pipeline_slots = 2; // batches in flight per device
+
+const char *getErrorString(cl_int error)
+{
+  switch(error){
+    case 0: return "CL_SUCCESS";
+    case -1: return "CL_DEVICE_NOT_FOUND";
+    case -2: return "CL_DEVICE_NOT_AVAILABLE";
+    case -3: return "CL_COMPILER_NOT_AVAILABLE";
+    case -4: return "CL_MEM_OBJECT_ALLOCATION_FAILURE";
+    case -5: return "CL_OUT_OF_RESOURCES";
+    case -6: return "CL_OUT_OF_HOST_MEMORY";
+    case -7: return "CL_PROFILING_INFO_NOT_AVAILABLE";
+    case -8: return "CL_MEM_COPY_OVERLAP";
+    case -9: return "CL_IMAGE_FORMAT_MISMATCH";
+    case -10: return "CL_IMAGE_FORMAT_NOT_SUPPORTED";
+    case -11: return "CL_BUILD_PROGRAM_FAILURE";
+    case -12: return "CL_MAP_FAILURE";
+    case -13: return "CL_MISALIGNED_SUB_BUFFER_OFFSET";
+    case -14: return "CL_EXEC_STATUS_ERROR_FOR_EVENTS_IN_WAIT_LIST";
+    case -15: return "CL_COMPILE_PROGRAM_FAILURE";
+    case -16: return "CL_LINKER_NOT_AVAILABLE";
+    case -17: return "CL_LINK_PROGRAM_FAILURE";
+    case -18: return "CL_DEVICE_PARTITION_FAILED";
+    case -19: return "CL_KERNEL_ARG_INFO_NOT_AVAILABLE";
+    case -30: return "CL_INVALID_VALUE";
+    case -31: return "CL_INVALID_DEVICE_TYPE";
+    case -32: return "CL_INVALID_PLATFORM";
+    case -33: return "CL_INVALID_DEVICE";
+    case -34: return "CL_INVALID_CONTEXT";
+    case -35: return "CL_INVALID_QUEUE_PROPERTIES";
+    case -36: return "CL_INVALID_COMMAND_QUEUE";
+    case -37: return "CL_INVALID_HOST_PTR";
+    case -38: return "CL_INVALID_MEM_OBJECT";
+    case -39: return "CL_INVALID_IMAGE_FORMAT_DESCRIPTOR";
+    case -40: return "CL_INVALID_IMAGE_SIZE";
+    case -41: return "CL_INVALID_SAMPLER";
+    case -42: return "CL_INVALID_BINARY";
+    case -43: return "CL_INVALID_BUILD_OPTIONS";
+    case -44: return "CL_INVALID_PROGRAM";
+    case -45: return "CL_INVALID_PROGRAM_EXECUTABLE";
+    case -46: return "CL_INVALID_KERNEL_NAME";
+    case -47: return "CL_INVALID_KERNEL_DEFINITION";
+    case -48: return "CL_INVALID_KERNEL";
+    case -49: return "CL_INVALID_ARG_INDEX";
+    case -50: return "CL_INVALID_ARG_VALUE";
+    case -51: return "CL_INVALID_ARG_SIZE";
+    case -52: return "CL_INVALID_KERNEL_ARGS";
+    case -53: return "CL_INVALID_WORK_DIMENSION";
+    case -54: return "CL_INVALID_WORK_GROUP_SIZE";
+    case -55: return "CL_INVALID_WORK_ITEM_SIZE";
+    case -56: return "CL_INVALID_GLOBAL_OFFSET";
+    case -57: return "CL_INVALID_EVENT_WAIT_LIST";
+    case -58: return "CL_INVALID_EVENT";
+    case -59: return "CL_INVALID_OPERATION";
+    case -60: return "CL_INVALID_GL_OBJECT";
+    case -61: return "CL_INVALID_BUFFER_SIZE";
+    case -62: return "CL_INVALID_MIP_LEVEL";
+    case -63: return "CL_INVALID_GLOBAL_WORK_SIZE";
+    case -64: return "CL_INVALID_PROPERTY";
+    case -65: return "CL_INVALID_IMAGE_DESCRIPTOR";
+    case -66: return "CL_INVALID_COMPILER_OPTIONS";
+    case -67: return "CL_INVALID_LINKER_OPTIONS";
+    case -68: return "CL_INVALID_DEVICE_PARTITION_COUNT";
+
+    case -1000: return "CL_INVALID_GL_SHAREGROUP_REFERENCE_KHR";
+    case -1001: return "CL_PLATFORM_NOT_FOUND_KHR";
+    case -1002: return "CL_INVALID_D3D10_DEVICE_KHR";
+    case -1003: return "CL_INVALID_D3D10_RESOURCE_KHR";
+    case -1004: return "CL_D3D10_RESOURCE_ALREADY_ACQUIRED_KHR";
+    case -1005: return "CL_D3D10_RESOURCE_NOT_ACQUIRED_KHR";
+    default: return "Unknown OpenCL error";
+  }
+}
+
+using pfnPezyExtSetPerThreadStackSize = CL_API_ENTRY cl_int (CL_API_CALL *) (pzcl_kernel kernel, size_t size);
+
+class PzclDevice : public Device {
+ public:
+  PzclDevice(cl_uint index, cl_device_id device_id,
+      const unsigned char *binary, std::size_t size, const SolverConfig &config)
+    : index(index), config(config),
+      global_work_size(config.work_items ? config.work_items : default_work_size),
+      next_slot(0), in_flight(0), total_stats(global_work_size) {
+    cl_int result = 0;
+    context = clCreateContext(nullptr, 1, &device_id, nullptr, nullptr, &result);
+    command_queue = clCreateCommandQueue(context, device_id, 0, &result);
+    upload_queue = clCreateCommandQueue(context, device_id, 0, &result);
+    readback_queue = clCreateCommandQueue(context, device_id, 0, &result);
+
+    std::cerr << "create program" << std::endl;
+    cl_int binary_status = 0;
+    program = clCreateProgramWithBinary(context, 1, &device_id, &size, &binary, &binary_status, &result);
+
+    std::cerr << "create kernel" << std::endl;
+    kernel = clCreateKernel(program, "Solve", &result);
+
+    std::cerr << "create buffer" << std::endl;
+    mem_ustack = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(UpperNode)*global_work_size*config.upper_stack_size, nullptr, &result);
+    mem_lstack = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(Node)*global_work_size*config.lower_stack_size, nullptr, &result);
+    for (Slot &slot : slots) {
+      slot.mem_stats = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(ThreadStats)*global_work_size, nullptr, &result);
+      slot.stats.resize(global_work_size);
+    }
+    mem_table = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(TableEntry)*std::max<size_t>(config.table_size, 1), nullptr, &result);
+    clear_table();
+    mem_counter = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(size_t), nullptr, &result);
+    mem_weights = clCreateBuffer(context, CL_MEM_READ_ONLY, sizeof(short)*pattern_weight_count, nullptr, &result);
+    if (config.pattern_weights) {
+      clEnqueueWriteBuffer(command_queue, mem_weights, CL_TRUE, 0, sizeof(short)*pattern_weight_count, config.pattern_weights, 0, nullptr, nullptr);
+    }
+
+    // pfnPezyExtSetPerThreadStackSize clExtSetPerThreadStackSize = (pfnPezyExtSetPerThreadStackSize)clGetExtensionFunctionAddress("pezy_set_per_thread_stack_size");
+    // constexpr size_t per_thread_stack = 0x1000;
+    // result = clExtSetPerThreadStackSize(kernel, per_thread_stack);
+    // if (result != CL_SUCCESS) {
+    //   std::cerr << getErrorString(result) << std::endl;
+    // }
+  }
+  ~PzclDevice() {
+    while (in_flight) finish(); // batches still running use the kernel and buffers
+    clReleaseKernel(kernel);
+    clReleaseProgram(program);
+    for (Slot &slot : slots) {
+      release_problem_buffers(slot);
+      clReleaseMemObject(slot.mem_stats);
+    }
+    clReleaseMemObject(mem_ustack);
+    clReleaseMemObject(mem_lstack);
+    clReleaseMemObject(mem_table);
+    clReleaseMemObject(mem_counter);
+    clReleaseMemObject(mem_weights);
+    clReleaseCommandQueue(readback_queue);
+    clReleaseCommandQueue(upload_queue);
+    clReleaseCommandQueue(command_queue);
+    clReleaseContext(context);
+  }
+  std::string name() const override {
+    return "pzcl" + std::to_string(index);
+  }
+  std::size_t min_batch_size() const override {
+    return global_work_size;
+  }
+  void solve(const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count) override {
+    submit(problems, results, count);
+    finish();
+  }
+  // Upload on upload_queue, kernel on command_queue, readback on
+  // readback_queue, chained by events. Each in-order queue only holds one
+  // kind of command, so the upload of the next batch does not wait behind
+  // the readback of the previous one and overlaps its kernel.
+  void submit(const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count) override {
+    Slot &slot = slots[next_slot];
+    next_slot = (next_slot + 1) % pipeline_slots;
+    ++in_flight;
+    slot.count = count;
+    if (count == 0) return;
+    reserve(slot, count);
+    cl_event uploaded, computed;
+    cl_int result = clEnqueueWriteBuffer(upload_queue, slot.mem_prob, CL_FALSE, 0, sizeof(AlphaBetaProblem)*count, problems, 0, nullptr, &uploaded);
+    if (result != CL_SUCCESS) {
+      std::cerr << "write buffer error: " << getErrorString(result) << std::endl;
+    }
+    clFlush(upload_queue);
+    clEnqueueWriteBuffer(command_queue, mem_counter, CL_FALSE, 0, sizeof(size_t), &zero_counter, 0, nullptr, nullptr);
+
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), (void *)&slot.mem_prob);
+    clSetKernelArg(kernel, 1, sizeof(cl_mem), (void *)&slot.mem_res);
+    clSetKernelArg(kernel, 2, sizeof(cl_mem), (void *)&mem_ustack);
+    clSetKernelArg(kernel, 3, sizeof(cl_mem), (void *)&mem_lstack);
+    clSetKernelArg(kernel, 4, sizeof(size_t), (void *)&count);
+    clSetKernelArg(kernel, 5, sizeof(size_t), (void *)&config.upper_stack_size);
+    clSetKernelArg(kernel, 6, sizeof(size_t), (void *)&config.lower_stack_size);
+    clSetKernelArg(kernel, 7, sizeof(cl_mem), (void *)&mem_table);
+    clSetKernelArg(kernel, 8, sizeof(size_t), (void *)&config.table_size);
+    clSetKernelArg(kernel, 9, sizeof(cl_mem), (void *)&slot.mem_stats);
+    clSetKernelArg(kernel, 10, sizeof(cl_mem), (void *)&mem_counter);
+    clSetKernelArg(kernel, 11, sizeof(size_t), (void *)&config.fastest_first_empties);
+    clSetKernelArg(kernel, 12, sizeof(size_t), (void *)&config.node_budget);
+    clSetKernelArg(kernel, 13, sizeof(size_t), (void *)&config.ordering);
+    clSetKernelArg(kernel, 14, sizeof(size_t), (void *)&config.ordering_empties);
+    clSetKernelArg(kernel, 15, sizeof(cl_mem), (void *)&mem_weights);
+
+    result = clEnqueueNDRangeKernel(command_queue, kernel, 1, nullptr, &global_work_size, nullptr, 1, &uploaded, &computed);
+    if (result != CL_SUCCESS) {
+      std::cerr << "kernel launch error: " << getErrorString(result) << std::endl;
+    }
+    clFlush(command_queue);
+
+    result = clEnqueueReadBuffer(readback_queue, slot.mem_res, CL_FALSE, 0, sizeof(AlphaBetaResult)*count, results, 1, &computed, nullptr);
+    if (result != CL_SUCCESS) {
+      std::cerr << "read buffer error: " << getErrorString(result) << std::endl;
+    }
+    clEnqueueReadBuffer(readback_queue, slot.mem_stats, CL_FALSE, 0, sizeof(ThreadStats)*global_work_size, slot.stats.data(), 1, &computed, &slot.done);
+    clFlush(readback_queue);
+    clReleaseEvent(uploaded);
+    clReleaseEvent(computed);
+  }
+  void finish() override {
+    if (in_flight == 0) return;
+    Slot &slot = slots[(next_slot + pipeline_slots - in_flight) % pipeline_slots];
+    --in_flight;
+    if (slot.count == 0) return;
+    clWaitForEvents(1, &slot.done);
+    clReleaseEvent(slot.done);
+    for (size_t i = 0; i < global_work_size; ++i) {
+      total_stats[i].nodes_total += slot.stats[i].nodes_total;
+      total_stats[i].table_hits += slot.stats[i].table_hits;
+      total_stats[i].table_misses += slot.stats[i].table_misses;
+    }
+  }
+  std::size_t pipeline_depth() const override {
+    return pipeline_slots;
+  }
+  std::vector<ThreadStats> thread_stats() const override {
+    return total_stats;
+  }
+ private:
+  // buffers of one batch in flight
+  struct Slot {
+    std::size_t capacity = 0;
+    std::size_t count = 0;
+    cl_mem mem_prob = nullptr;
+    cl_mem mem_res = nullptr;
+    cl_mem mem_stats = nullptr;
+    cl_event done = nullptr; // stats read back, the last command of the batch
+    std::vector<ThreadStats> stats;
+  };
+  void reserve(Slot &slot, std::size_t count) {
+    if (count <= slot.capacity) return;
+    release_problem_buffers(slot);
+    cl_int result = 0;
+    slot.mem_prob = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(AlphaBetaProblem)*count, nullptr, &result);
+    slot.mem_res = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(AlphaBetaResult)*count, nullptr, &result);
+    slot.capacity = count;
+  }
+  void clear_table() {
+    constexpr size_t chunk = 1 << 16;
+    const std::vector<TableEntry> zero(chunk, (TableEntry){0, 0, 0});
+    for (size_t i = 0; i < config.table_size; i += chunk) {
+      const size_t n = std::min(chunk, config.table_size - i);
+      clEnqueueWriteBuffer(command_queue, mem_table, CL_TRUE, sizeof(TableEntry)*i, sizeof(TableEntry)*n, zero.data(), 0, nullptr, nullptr);
+    }
+  }
+  void release_problem_buffers(Slot &slot) {
+    if (slot.mem_prob) clReleaseMemObject(slot.mem_prob);
+    if (slot.mem_res) clReleaseMemObject(slot.mem_res);
+    slot.mem_prob = slot.mem_res = nullptr;
+    slot.capacity = 0;
+  }
+  cl_uint index;
+  SolverConfig config;
+  size_t global_work_size;
+  cl_context context;
+  cl_command_queue command_queue;
+  cl_command_queue upload_queue;
+  cl_command_queue readback_queue;
+  cl_program program;
+  cl_kernel kernel;
+  Slot slots[pipeline_slots];
+  std::size_t next_slot;
+  std::size_t in_flight;
+  const size_t zero_counter = 0;
+  cl_mem mem_ustack;
+  cl_mem mem_lstack;
+  cl_mem mem_table;
+  cl_mem mem_counter;
+  cl_mem mem_weights;
+  std::vector<ThreadStats> total_stats;
+};
+
+} // namespace
+
+std::vector<std::unique_ptr<Device>> open_pzcl_devices(const char *binary_path, const SolverConfig &config) {
+  cl_platform_id platform_id = nullptr;
+  cl_uint num_platforms = 0;
+  clGetPlatformIDs(1, &platform_id, &num_platforms);
+  std::cerr << "Number of platforms: " << num_platforms << std::endl;
+
+  cl_uint num_devices = 0;
+  clGetDeviceIDs(platform_id, CL_DEVICE_TYPE_DEFAULT, 0, nullptr, &num_devices);
+  std::cerr << "Number of devices: " << num_devices << std::endl;
+
+  std::vector<cl_device_id> device_ids(num_devices);
+  clGetDeviceIDs(platform_id, CL_DEVICE_TYPE_DEFAULT, num_devices, device_ids.data(), nullptr);
+
+  std::cerr << "load program" << std::endl;
+  unsigned char *binary = (unsigned char *)malloc(MAX_BIN_SIZE * sizeof(char));
+  FILE *fp = fopen(binary_path, "rb");
+  if (fp == nullptr) {
+    std::cerr << "cannot open " << binary_path << std::endl;
+    free(binary);
+    return {};
+  }
+  std::size_t size = fread(binary, sizeof(char), MAX_BIN_SIZE, fp);
+  fclose(fp);
+
+  std::vector<std::unique_ptr<Device>> devices;
+  for (cl_uint i = 0; i < num_devices; ++i) {
+    std::cerr << "Device " << i << std::endl;
+    devices.emplace_back(new PzclDevice(i, device_ids[i], binary, size, config));
+  }
+  free(binary);
+  return devices;
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <map>
+#include "report.hpp"
+#include "board.hpp"
+
+namespace {
+
+struct EmptiesSummary {
+  std::size_t count = 0;
+  ull nodes_total = 0;
+  ull nodes_min = ~UINT64_C(0);
+  ull nodes_max = 0;
+  std::vector<std::size_t> histogram; // [i]: problems with 2^i <= nodes < 2^(i+1)
+};
+
+int log2_floor(ull x) {
+  int res = 0;
+  while (x >>= 1) ++res;
+  return res;
+}
+
+double ratio(double num, double den) {
+  return den > 0 ? num / den : 0.0;
+}
+
+std::string quote(const std::string &str) {
+  std::string res = "\"";
+  for (char c : str) {
+    if (c == '"' || c == '\\') res += '\\';
+    res += c;
+  }
+  return res + '"';
+}
+
+} // namespace
+
+void write_report(std::ostream &os, const RunInfo &info,
+    const std::vector<std::unique_ptr<Device>> &devices,
+    const AlphaBetaProblem *problems, const AlphaBetaResult *results) {
+  // per result, so with copies of dedup fan-out and zero-node cache hits
+  ull result_nodes = 0;
+  std::map<int, EmptiesSummary> by_empties;
+  for (std::size_t i = 0; i < info.count; ++i) {
+    const ull n = results[i].nodes;
+    result_nodes += n;
+    EmptiesSummary &summary = by_empties[64 - stones_count(problems[i].me, problems[i].op)];
+    ++summary.count;
+    summary.nodes_total += n;
+    summary.nodes_min = std::min(summary.nodes_min, n);
+    summary.nodes_max = std::max(summary.nodes_max, n);
+    const std::size_t bucket = n ? log2_floor(n) : 0;
+    if (summary.histogram.size() <= bucket) summary.histogram.resize(bucket + 1);
+    ++summary.histogram[bucket];
+  }
+
+  os << "{\n";
+  os << "  \"backend\": " << quote(info.backend) << ",\n";
+  os << "  \"problems\": " << info.count << ",\n";
+  os << "  \"elapsed\": " << info.elapsed << ",\n";
+  os << "  \"stack_bytes_per_thread\": " << info.stack_bytes << ",\n";
+
+  // nodes actually searched, from the devices' own counters as in print_stats
+  std::vector<std::vector<ThreadStats>> device_stats;
+  ull nodes = 0;
+  for (const auto &device : devices) {
+    device_stats.push_back(device->thread_stats());
+    for (const ThreadStats &s : device_stats.back()) nodes += s.nodes_total;
+  }
+  os << "  \"nodes\": " << nodes << ",\n";
+  os << "  \"nps\": " << ratio(nodes, info.elapsed) << ",\n";
+  os << "  \"result_nodes\": " << result_nodes << ",\n";
+
+  ull all_max = 0, all_total = 0, all_threads = 0, table_hits = 0, table_misses = 0;
+  os << "  \"devices\": [";
+  for (std::size_t d = 0; d < devices.size(); ++d) {
+    const Device &device = *devices[d];
+    const std::vector<ThreadStats> &stats = device_stats[d];
+    ull total = 0, max_nodes = 0;
+    for (const ThreadStats &s : stats) {
+      total += s.nodes_total;
+      max_nodes = std::max(max_nodes, s.nodes_total);
+      table_hits += s.table_hits;
+      table_misses += s.table_misses;
+    }
+    all_total += total;
+    all_max = std::max(all_max, max_nodes);
+    all_threads += stats.size();
+    const double mean = ratio(total, stats.size());
+    const DeviceUsage &usage = device.usage();
+    os << (d ? ",\n" : "\n");
+    os << "    {\"name\": " << quote(device.name())
+       << ", \"seconds\": " << usage.seconds
+       << ", \"problems\": " << usage.problems
+       << ", \"batches\": " << usage.batches
+       << ", \"nodes\": " << total
+       << ", \"nps\": " << ratio(total, usage.seconds)
+       << ", \"threads\": " << stats.size()
+       << ", \"thread_nodes_max\": " << max_nodes
+       << ", \"thread_nodes_mean\": " << mean
+       << ", \"imbalance\": " << ratio(max_nodes, mean) << "}";
+  }
+  os << "\n  ],\n";
+  os << "  \"imbalance\": " << ratio(all_max, ratio(all_total, all_threads)) << ",\n";
+  os << "  \"table\": {\"hits\": " << table_hits << ", \"misses\": " << table_misses << "},\n";
+
+  os << "  \"empties\": [";
+  bool first = true;
+  for (const auto &item : by_empties) {
+    const EmptiesSummary &summary = item.second;
+    os << (first ? "\n" : ",\n");
+    first = false;
+    os << "    {\"empties\": " << item.first
+       << ", \"count\": " << summary.count
+       << ", \"nodes_total\": " << summary.nodes_total
+       << ", \"nodes_min\": " << summary.nodes_min
+       << ", \"nodes_max\": " << summary.nodes_max
+       << ", \"nodes_mean\": " << ratio(summary.nodes_total, summary.count)
+       << ", \"log2_histogram\": [";
+    for (std::size_t i = 0; i < summary.histogram.size(); ++i) {
+      os << (i ? ", " : "") << summary.histogram[i];
+    }
+    os << "]}";
+  }
+  os << "\n  ]\n";
+  os << "}\n";
+}
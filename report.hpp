@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "device.hpp"
+
+struct RunInfo {
+  std::string backend;
+  std::size_t count;
+  double elapsed;
+  std::size_t stack_bytes; // solver stacks per device thread
+};
+
+// machine-readable summary of a run: throughput, per-device time and
+// load balance, and the distribution of nodes per problem by empty count
+void write_report(std::ostream &os, const RunInfo &info,
+    const std::vector<std::unique_ptr<Device>> &devices,
+    const AlphaBetaProblem *problems, const AlphaBetaResult *results);
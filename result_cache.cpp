@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include "result_cache.hpp"
+#include "symmetry.hpp"
+
+namespace {
+
+constexpr char cache_magic[8] = {'P', 'Z', 'O', 'T', 'H', 'C', 'A', '1'};
+constexpr std::size_t bucket_size = 4;
+
+// FileHeader::count is the number of slots
+struct CacheHeader {
+  FileHeader file;
+  ull generation; // runs that opened the file
+  ull reserved;
+};
+
+std::size_t slots_for(std::size_t megabytes) {
+  const std::size_t limit = megabytes * 1024 * 1024 / sizeof(CacheEntry);
+  std::size_t slots = bucket_size;
+  while (slots * 2 <= limit) slots *= 2;
+  return slots;
+}
+
+bool valid(const MappedFile &file) {
+  if (file.size() < sizeof(CacheHeader)) return false;
+  const CacheHeader *header = reinterpret_cast<const CacheHeader *>(file.data());
+  return std::memcmp(header->file.magic, cache_magic, sizeof(cache_magic)) == 0 &&
+    header->file.count >= bucket_size &&
+    file.size() == sizeof(CacheHeader) + header->file.count * sizeof(CacheEntry);
+}
+
+} // namespace
+
+bool ResultCache::open(const std::string &path, std::size_t megabytes) {
+  const std::size_t want = slots_for(megabytes);
+  MappedFile old;
+  if (std::FILE *fp = std::fopen(path.c_str(), "rb")) {
+    std::fclose(fp);
+    if (!old.open_read(path)) return false;
+    if (!valid(old)) {
+      std::cerr << path << ": not a cache file" << std::endl;
+      return false;
+    }
+  }
+  const CacheHeader *old_header = old.size() ? reinterpret_cast<const CacheHeader *>(old.data()) : nullptr;
+  if (old_header && old_header->file.count == want) {
+    old.close();
+    if (!file.open_write(path)) return false;
+  } else {
+    // new file, or rebuild at the requested size
+    const std::string tmp = path + ".tmp";
+    if (!file.create(tmp, sizeof(CacheHeader) + want * sizeof(CacheEntry))) return false;
+    CacheHeader header = {};
+    std::memcpy(header.file.magic, cache_magic, sizeof(cache_magic));
+    header.file.count = want;
+    header.generation = old_header ? old_header->generation : 0;
+    std::memcpy(file.data(), &header, sizeof(header));
+    entries = reinterpret_cast<CacheEntry *>(file.data() + sizeof(CacheHeader));
+    slots = want;
+    if (old_header) {
+      const CacheEntry *old_entries = reinterpret_cast<const CacheEntry *>(old.data() + sizeof(CacheHeader));
+      for (ull i = 0; i < old_header->file.count; ++i) {
+        if (old_entries[i].generation) insert(old_entries[i]);
+      }
+    }
+    old.close();
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+      std::cerr << "cannot rename " << tmp << std::endl;
+      file.close();
+      entries = nullptr;
+      return false;
+    }
+  }
+  CacheHeader *header = reinterpret_cast<CacheHeader *>(file.data());
+  generation = ++header->generation;
+  entries = reinterpret_cast<CacheEntry *>(file.data() + sizeof(CacheHeader));
+  slots = header->file.count;
+  return true;
+}
+
+CacheEntry *ResultCache::lookup(ull me, ull op) {
+  ull h = (me ^ (op * UINT64_C(0x9E3779B97F4A7C15))) * UINT64_C(0xC2B2AE3D27D4EB4F);
+  CacheEntry *bucket = entries + ((h >> 32) & (slots - 1) & ~(bucket_size - 1));
+  CacheEntry *victim = bucket;
+  for (std::size_t i = 0; i < bucket_size; ++i) {
+    CacheEntry &entry = bucket[i];
+    if (entry.generation && entry.me == me && entry.op == op) return &entry;
+    if (entry.generation < victim->generation ||
+        (entry.generation == victim->generation && entry.nodes < victim->nodes)) {
+      victim = &entry;
+    }
+  }
+  return victim;
+}
+
+bool ResultCache::matches(const CacheEntry *entry, ull me, ull op) {
+  return entry->generation && entry->me == me && entry->op == op;
+}
+
+void ResultCache::insert(const CacheEntry &entry) {
+  CacheEntry *slot = lookup(entry.me, entry.op);
+  if (matches(slot, entry.me, entry.op) || slot->generation <= entry.generation) *slot = entry;
+}
+
+bool ResultCache::find(const AlphaBetaProblem &problem, AlphaBetaResult &result) {
+  const Board bd = canonical(problem.me, problem.op);
+  CacheEntry *entry = lookup(bd.me, bd.op);
+  if (!matches(entry, bd.me, bd.op)) return false;
+  entry->generation = generation;
+  int score;
+  if (entry->lower == entry->upper) {
+    score = entry->lower;
+  } else if (entry->upper <= problem.alpha) {
+    score = entry->upper;
+  } else if (entry->lower >= problem.beta) {
+    score = entry->lower;
+  } else {
+    return false;
+  }
+  result = (AlphaBetaResult){0, score, false, 0, 0};
+  if (entry->lower == entry->upper) result.move = map_move(bd, Board(problem.me, problem.op), entry->move);
+  ++hits;
+  return true;
+}
+
+void ResultCache::update(const AlphaBetaProblem &problem, const AlphaBetaResult &result) {
+  const Board bd = canonical(problem.me, problem.op);
+  CacheEntry *entry = lookup(bd.me, bd.op);
+  int lower = -64, upper = 64;
+  if (matches(entry, bd.me, bd.op)) {
+    lower = entry->lower;
+    upper = entry->upper;
+  } else {
+    *entry = (CacheEntry){bd.me, bd.op, 0, 0, -64, 64, 0, 0};
+  }
+  if (result.score <= problem.alpha) {
+    upper = std::min(upper, result.score);
+  } else if (result.score >= problem.beta) {
+    lower = std::max(lower, result.score);
+  } else {
+    lower = upper = result.score;
+    entry->move = map_move(Board(problem.me, problem.op), bd, result.move);
+  }
+  if (lower > upper) lower = upper = result.score;
+  entry->lower = lower;
+  entry->upper = upper;
+  entry->nodes += result.nodes;
+  entry->generation = generation;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include "problem_file.hpp"
+#include "solver.hpp"
+
+// Results of earlier runs, kept in a memory-mapped file across runs: score
+// bounds and node count per position, keyed by the canonical form under the
+// 8 board symmetries. The file is a fixed-size hash table of 4-entry
+// buckets. A full bucket evicts the entry least recently used (by run),
+// the cheaper one (fewer nodes) among equals.
+struct CacheEntry {
+  ull me;
+  ull op;
+  ull nodes;
+  uint32_t generation; // run that last used this entry, 0 for a free slot
+  char lower;
+  char upper;
+  unsigned char move; // AlphaBetaResult::move of the canonical position if exact
+  char pad;
+};
+
+class ResultCache {
+ public:
+  ResultCache() : hits(0), entries(nullptr), slots(0), generation(0) {}
+  // Opens path, or creates it. The table holds megabytes MiB; an existing
+  // file of another size is rebuilt, keeping the most recent entries.
+  bool open(const std::string &path, std::size_t megabytes);
+  bool enabled() const { return entries != nullptr; }
+  // true if the cached bounds settle problem, with the result (0 nodes)
+  bool find(const AlphaBetaProblem &problem, AlphaBetaResult &result);
+  // records the result of a search of problem
+  void update(const AlphaBetaProblem &problem, const AlphaBetaResult &result);
+  std::size_t hits;
+ private:
+  static bool matches(const CacheEntry *entry, ull me, ull op);
+  // the entry of (me, op), or else the slot to replace in its bucket
+  CacheEntry *lookup(ull me, ull op);
+  void insert(const CacheEntry &entry);
+  MappedFile file;
+  CacheEntry *entries;
+  std::size_t slots;
+  uint32_t generation;
+};
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "service.hpp"
+#include "to_board.hpp"
+#include "pv.hpp"
+
+namespace {
+
+constexpr std::size_t board_str_size = 16;
+
+// one side of a conversation; answers are written whole lines at a time
+class Client {
+ public:
+  Client(int in_fd, int out_fd, bool owns_fd) : in_fd(in_fd), out_fd(out_fd), owns_fd(owns_fd) {}
+  ~Client() {
+    if (owns_fd) ::close(in_fd);
+  }
+  // reads the next '\n' terminated line, false at the end of the input
+  bool read_line(std::string &line) {
+    while (true) {
+      const std::size_t eol = buffer.find('\n', start);
+      if (eol != std::string::npos) {
+        line.assign(buffer, start, eol - start);
+        start = eol + 1;
+        return true;
+      }
+      buffer.erase(0, start);
+      start = 0;
+      char chunk[4096];
+      const ssize_t n = ::read(in_fd, chunk, sizeof(chunk));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) {
+        if (buffer.empty()) return false;
+        line.swap(buffer);
+        buffer.clear();
+        return true;
+      }
+      buffer.append(chunk, n);
+    }
+  }
+  void write(const std::string &text) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::size_t done = 0; done < text.size();) {
+      const ssize_t n = ::write(out_fd, text.data() + done, text.size() - done);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return; // the client went away
+      done += n;
+    }
+  }
+ private:
+  int in_fd, out_fd;
+  bool owns_fd;
+  std::string buffer;
+  std::size_t start = 0;
+  std::mutex mutex;
+};
+
+struct Request {
+  std::shared_ptr<Client> client;
+  std::string board; // as received
+  AlphaBetaProblem problem;
+  std::string error; // the request is answered with this if not empty
+  std::chrono::steady_clock::time_point arrival;
+};
+
+// requests of all clients in arrival order
+class RequestQueue {
+ public:
+  RequestQueue() : closed(false) {}
+  void push(Request &&request) {
+    std::lock_guard<std::mutex> lock(mutex);
+    requests.push_back(std::move(request));
+    cond.notify_one();
+  }
+  // Waits for the next micro-batch: up to batch_size requests, taken once
+  // that many wait or the oldest has waited window_ms. False once the queue
+  // is closed and drained.
+  bool pop_batch(std::size_t batch_size, int window_ms, std::vector<Request> &batch) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this] { return closed || !requests.empty(); });
+    if (requests.empty()) return false;
+    const auto deadline = requests.front().arrival + std::chrono::milliseconds(window_ms);
+    cond.wait_until(lock, deadline, [&] { return closed || requests.size() >= batch_size; });
+    const std::size_t size = std::min(batch_size, requests.size());
+    batch.assign(std::make_move_iterator(requests.begin()), std::make_move_iterator(requests.begin() + size));
+    requests.erase(requests.begin(), requests.begin() + size);
+    return true;
+  }
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    cond.notify_all();
+  }
+ private:
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::deque<Request> requests;
+  bool closed;
+};
+
+// a base-81 digit: three squares in base 3 in the low 5 bits (under 27)
+// and the fourth one times 32 above them, offset by 33
+bool is_board_char(char c) {
+  const int code = (unsigned char)c - 33;
+  return code >= 0 && code < 96 && (code & 31) < 27;
+}
+
+// "BOARD [ALPHA BETA]"; malformed requests carry their error
+Request parse_request(const std::string &line, const ServiceOptions &options) {
+  Request request = {nullptr, "", AlphaBetaProblem(0, 0), "", std::chrono::steady_clock::now()};
+  std::istringstream is(line);
+  is >> request.board;
+  if (request.board.size() != board_str_size ||
+      !std::all_of(request.board.begin(), request.board.end(), is_board_char)) {
+    request.error = "bad board";
+    return request;
+  }
+  const Board bd = toBoard(request.board.c_str());
+  if (bd.me & bd.op) {
+    request.error = "bad board";
+    return request;
+  }
+  request.problem = AlphaBetaProblem(bd.me, bd.op);
+  if (options.set_window) request.problem = AlphaBetaProblem(bd.me, bd.op, options.alpha, options.beta);
+  int alpha, beta;
+  if (is >> alpha) {
+    if (!(is >> beta) || alpha < -64 || beta > 64 || alpha >= beta) {
+      request.error = "bad window";
+      return request;
+    }
+    request.problem = AlphaBetaProblem(bd.me, bd.op, alpha, beta);
+  }
+  return request;
+}
+
+// detached readers of socket clients share the queue, and own a copy of
+// the options, so that neither outlives them
+void read_requests(std::shared_ptr<Client> client, ServiceOptions options, std::shared_ptr<RequestQueue> queue) {
+  std::string line;
+  while (client->read_line(line)) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+    Request request = parse_request(line, options);
+    request.client = client;
+    queue->push(std::move(request));
+  }
+}
+
+void answer_batch(std::vector<Request> &batch, const SolveFunction &solve, const ServiceOptions &options) {
+  std::vector<AlphaBetaProblem> problems;
+  std::vector<std::size_t> index;
+  for (std::size_t i = 0; i < batch.size(); ++i) {
+    if (!batch[i].error.empty()) continue;
+    problems.push_back(batch[i].problem);
+    index.push_back(i);
+  }
+  std::vector<AlphaBetaResult> results(problems.size());
+  if (!problems.empty()) solve(problems.data(), results.data(), problems.size());
+  std::vector<std::string> answers(batch.size());
+  for (std::size_t k = 0; k < index.size(); ++k) {
+    const int score = results[k].score;
+    std::string &answer = answers[index[k]];
+    answer = batch[index[k]].board + ' ';
+    if (options.sign_scores) answer += std::to_string((score > 0) - (score < 0));
+    else answer += std::to_string(score);
+    if (options.best_move) {
+      const bool exact = score > problems[k].alpha && score < problems[k].beta && results[k].move;
+      answer += ' ' + (exact ? move_name(results[k].move) : std::string("-"));
+    }
+    answer += ' ' + std::to_string(results[k].nodes) + '\n';
+  }
+  // one write per client, in request order
+  std::map<Client *, std::string> text;
+  for (std::size_t i = 0; i < batch.size(); ++i) {
+    text[batch[i].client.get()] += batch[i].error.empty() ? answers[i] : "error: " + batch[i].error + '\n';
+  }
+  for (auto &entry : text) entry.first->write(entry.second);
+}
+
+int listen_unix(const std::string &path) {
+  sockaddr_un addr;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "socket path too long: " << path << std::endl;
+    return -1;
+  }
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    std::cerr << "cannot create socket: " << std::strerror(errno) << std::endl;
+    return -1;
+  }
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::strcpy(addr.sun_path, path.c_str());
+  unlink(path.c_str());
+  if (bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 64) < 0) {
+    std::cerr << "cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+} // namespace
+
+bool serve(const std::string &socket_path, const SolveFunction &solve,
+    const ServiceOptions &options, ServiceStats &stats) {
+  stats = (ServiceStats){0, 0};
+  std::signal(SIGPIPE, SIG_IGN); // a client that hangs up only loses its answers
+  std::shared_ptr<RequestQueue> queue = std::make_shared<RequestQueue>();
+  bool ok = true;
+  std::thread source;
+  if (socket_path.empty()) {
+    source = std::thread([&] {
+      read_requests(std::make_shared<Client>(STDIN_FILENO, STDOUT_FILENO, false), options, queue);
+      queue->close();
+    });
+  } else {
+    const int listen_fd = listen_unix(socket_path);
+    if (listen_fd < 0) return false;
+    std::cerr << "listening on " << socket_path << std::endl;
+    source = std::thread([&, listen_fd] {
+      while (true) {
+        const int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+          if (errno == EINTR || errno == ECONNABORTED) continue;
+          std::cerr << "accept failed: " << std::strerror(errno) << std::endl;
+          ok = false;
+          break;
+        }
+        std::thread(read_requests, std::make_shared<Client>(fd, fd, true), options, queue).detach();
+      }
+      ::close(listen_fd);
+      queue->close();
+    });
+  }
+  std::vector<Request> batch;
+  while (queue->pop_batch(std::max<std::size_t>(1, options.batch_size), options.window_ms, batch)) {
+    answer_batch(batch, solve, options);
+    stats.requests += batch.size();
+    ++stats.batches;
+  }
+  source.join();
+  return ok;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include "dispatch.hpp"
+
+struct ServiceOptions {
+  std::size_t batch_size; // solve as soon as this many requests wait
+  int window_ms;          // or when the oldest request has waited this long
+  bool set_window;        // search every request without its own window with (alpha, beta)
+  int alpha;
+  int beta;
+  bool sign_scores;       // answer scores as -1, 0, 1 (win/loss/draw)
+  bool best_move;         // answer the best move of exact scores after them
+};
+
+struct ServiceStats {
+  std::size_t requests;
+  std::size_t batches;
+};
+
+// Answers solve requests with the already initialized devices behind solve.
+// A request is one line "BOARD [ALPHA BETA]" (BOARD in base-81) and gets the
+// line "BOARD SCORE [MOVE] NODES", or "error: ..."; each client gets its answers in
+// request order. Requests of all clients are collected into micro-batches
+// by options.batch_size and options.window_ms. With an empty socket_path the
+// requests come from stdin and the answers go to stdout until stdin ends;
+// otherwise every connection to the Unix domain socket is a client and the
+// service runs until it fails.
+bool serve(const std::string &socket_path, const SolveFunction &solve,
+    const ServiceOptions &options, ServiceStats &stats);
@@ -0,0 +1,135 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "shard.hpp"
+#include "symmetry.hpp"
+
+namespace {
+
+constexpr char shard_magic[8] = {'P', 'Z', 'O', 'T', 'H', 'S', 'H', '1'};
+
+ull mix(ull x) {
+  x ^= x >> 31;
+  x *= UINT64_C(0xbf58476d1ce4e5b9);
+  x ^= x >> 29;
+  return x;
+}
+
+bool write_all(int fd, const void *data, std::size_t size) {
+  const char *ptr = static_cast<const char *>(data);
+  while (size > 0) {
+    const ssize_t written = ::write(fd, ptr, size);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    ptr += written;
+    size -= written;
+  }
+  return true;
+}
+
+} // namespace
+
+bool parse_shard(const std::string &str, ShardSpec &spec) {
+  const std::size_t slash = str.find('/');
+  if (slash == std::string::npos || slash == 0 || slash + 1 == str.size()) return false;
+  if (str.find_first_not_of("0123456789/") != std::string::npos) return false;
+  spec.shard = std::stoul(str.substr(0, slash));
+  spec.shards = std::stoul(str.substr(slash + 1));
+  return spec.shards > 0 && spec.shard < spec.shards;
+}
+
+bool in_shard(const ShardSpec &spec, const AlphaBetaProblem &problem, std::size_t index, std::size_t total) {
+  if (spec.by_hash) {
+    const Board board = canonical(problem.me, problem.op);
+    return mix(mix(board.me) ^ board.op) % spec.shards == spec.shard;
+  }
+  return (ull)index * spec.shards / total == spec.shard; // contiguous ranges
+}
+
+ull input_hash(const AlphaBetaProblem *problems, std::size_t count) {
+  ull hash = mix(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const AlphaBetaProblem &problem = problems[i];
+    hash = mix(hash ^ problem.me);
+    hash = mix(hash ^ problem.op);
+    hash = mix(hash ^ (ull)(unsigned)(problem.alpha * 256 + problem.beta));
+  }
+  return hash;
+}
+
+bool read_shard_file(const std::string &path, ShardHeader &header, std::vector<ShardRecord> &records) {
+  std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+  if (!ifs) {
+    std::cerr << "cannot open " << path << std::endl;
+    return false;
+  }
+  const std::size_t size = ifs.tellg();
+  ifs.seekg(0);
+  if (size < sizeof(header) || !ifs.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, shard_magic, sizeof(shard_magic)) != 0) {
+    std::cerr << path << ": not a shard file" << std::endl;
+    return false;
+  }
+  records.resize((size - sizeof(header)) / sizeof(ShardRecord));
+  if (!ifs.read(reinterpret_cast<char *>(records.data()), records.size() * sizeof(ShardRecord))) {
+    std::cerr << "cannot read " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool ShardFile::open(const std::string &path, const ShardSpec &spec, ull input, std::size_t total) {
+  close();
+  this->path = path;
+  done.clear();
+  ShardHeader expected;
+  std::memcpy(expected.magic, shard_magic, sizeof(shard_magic));
+  expected.input = input;
+  expected.total = total;
+  expected.shard = spec.shard;
+  expected.shards = spec.shards;
+  expected.by_hash = spec.by_hash;
+  struct stat st;
+  if (::stat(path.c_str(), &st) == 0 && (std::size_t)st.st_size >= sizeof(ShardHeader)) {
+    ShardHeader header;
+    if (!read_shard_file(path, header, done)) return false;
+    if (header.input != expected.input || header.total != expected.total || header.shard != expected.shard ||
+        header.shards != expected.shards || header.by_hash != expected.by_hash) {
+      std::cerr << path << ": shard file of another input or shard" << std::endl;
+      return false;
+    }
+    fd = ::open(path.c_str(), O_WRONLY);
+    if (fd < 0 || ftruncate(fd, sizeof(header) + done.size() * sizeof(ShardRecord)) < 0 ||
+        lseek(fd, 0, SEEK_END) < 0) {
+      std::cerr << "cannot resume " << path << std::endl;
+      return false;
+    }
+    return true;
+  }
+  // new, or a run that was interrupted before its header was complete
+  fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0 || !write_all(fd, &expected, sizeof(expected)) || fsync(fd) < 0) {
+    std::cerr << "cannot create " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool ShardFile::append(const ShardRecord *records, std::size_t count) {
+  if (!write_all(fd, records, count * sizeof(ShardRecord)) || fdatasync(fd) < 0) {
+    std::cerr << "cannot write " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void ShardFile::close() {
+  if (fd >= 0) ::close(fd);
+  fd = -1;
+}
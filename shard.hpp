@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "solver.hpp"
+
+// Splitting an input into shards solved by separate runs. A sharded run
+// appends the results of every finished chunk to its shard file, which is
+// therefore also its checkpoint: run again, it skips the problems already
+// in the file. merge puts the shard files back together in input order.
+
+struct ShardSpec {
+  std::size_t shard;  // this run's shard, < shards
+  std::size_t shards; // 0: not sharded
+  bool by_hash;       // by the hash of the canonical position instead of index ranges
+};
+
+// "K/N"
+bool parse_shard(const std::string &str, ShardSpec &spec);
+
+// whether problem index of total belongs to spec.shard; by hash, positions
+// equal up to symmetry fall into the same shard so that dedup still sees them
+bool in_shard(const ShardSpec &spec, const AlphaBetaProblem &problem, std::size_t index, std::size_t total);
+
+// identifies the input a shard file was made from
+ull input_hash(const AlphaBetaProblem *problems, std::size_t count);
+
+// A shard file is a ShardHeader followed by ShardRecords in the order the
+// chunks finished.
+struct ShardHeader {
+  char magic[8];
+  ull input;  // input_hash of the whole input
+  ull total;  // problems in the whole input
+  ull shard;
+  ull shards;
+  ull by_hash;
+};
+
+struct ShardRecord {
+  ull index;              // of the problem in the input
+  AlphaBetaResult result; // move is only kept for exact scores
+  int answer;             // of the host verification, or no_answer
+  int pad;
+};
+
+class ShardFile {
+ public:
+  ShardFile() : fd(-1) {}
+  ShardFile(const ShardFile &) = delete;
+  ShardFile& operator=(const ShardFile &) = delete;
+  ~ShardFile() { close(); }
+  // creates path for shard spec of an input, or opens the file of an
+  // earlier run of the same shard and input and reads its records; a
+  // record torn by an interrupted write is cut off
+  bool open(const std::string &path, const ShardSpec &spec, ull input, std::size_t total);
+  // appends records and flushes them to disk
+  bool append(const ShardRecord *records, std::size_t count);
+  void close();
+  const std::vector<ShardRecord> &records() const { return done; }
+ private:
+  int fd;
+  std::string path;
+  std::vector<ShardRecord> done;
+};
+
+// reads the header and the complete records of a shard file
+bool read_shard_file(const std::string &path, ShardHeader &header, std::vector<ShardRecord> &records);
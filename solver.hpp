@@ -1,7 +1,12 @@
 #pragma once
 #include "types.hpp"
 #include "board.hpp"
-//#include "table.cuh"
+#include "table.hpp"
+#include "pattern.hpp"
+
+// Positions with at most last_empties empties are solved by solve_last,
+// unrolled at compile time per empty count, instead of on the Node stack.
+constexpr int last_empties = 4;
 
 struct AlphaBetaProblem {
   AlphaBetaProblem(ull me, ull op, int alpha, int beta)
@@ -14,6 +19,32 @@ struct AlphaBetaProblem {
   int beta;
 };
 
+// If suspended, the node budget ran out first and the answer is only known
+// to lie in [score, upper]; escalate() re-solves such problems. move is a
+// best move if the score is exact; after a fail low it is just the first
+// move tried.
+struct AlphaBetaResult {
+  ull nodes;
+  int score;
+  bool suspended;
+  char upper;
+  unsigned char move; // 1 + square of the move, 0: no move (pass) or unknown
+};
+
+// whether score, from a search of problem's window, agrees with the exact
+// answer: a score outside the window only bounds it
+inline bool consistent(const AlphaBetaProblem &problem, int score, int answer) {
+  if (score <= problem.alpha) return answer <= score;
+  if (score >= problem.beta) return answer >= score;
+  return answer == score;
+}
+
+struct ThreadStats {
+  ull nodes_total;
+  ull table_hits;
+  ull table_misses;
+};
+
 class MobilityGenerator {
  public:
   MobilityGenerator() {}
@@ -39,6 +70,14 @@ class MobilityGenerator {
   bool completed() const {
     return not_checked_yet() == 0;
   }
+  // empty squares not handed out yet
+  ull remaining() const {
+    return not_checked_yet();
+  }
+  // mark bits (a subset of remaining()) as handed out
+  void remove(ull bits) {
+    reset(bits);
+  }
   MobilityGenerator move(ull flip, ull bit) const {
     ull p = player_pos();
     ull o = opponent_pos();
@@ -63,28 +102,70 @@ class MobilityGenerator {
   ull x, y;
 };
 
+// Score bounds from stable discs: me scores at least 2 * stable(me) - 64 and
+// at most 64 - 2 * stable(op). Returns true, with the bound in score, if one
+// of them already falls outside (alpha, beta). The disc counts gate the
+// stability computation.
+inline bool stability_cutoff(ull me, ull op, int alpha, int beta, int &score) {
+  if (64 - 2 * popcnt(op) <= alpha) {
+    const int upper = 64 - 2 * stable_count(op, me);
+    if (upper <= alpha) {
+      score = upper;
+      return true;
+    }
+  }
+  if (2 * popcnt(me) - 64 >= beta) {
+    const int lower = 2 * stable_count(me, op) - 64;
+    if (lower >= beta) {
+      score = lower;
+      return true;
+    }
+  }
+  return false;
+}
+
+// bit q is set if quadrant q (a1-d4, e1-h4, a5-d8, e5-h8) has an odd
+// number of empties
+inline unsigned char quadrant_parity(ull empty) {
+  return (popcnt(empty & UINT64_C(0x000000000F0F0F0F)) & 1)
+    | (popcnt(empty & UINT64_C(0x00000000F0F0F0F0)) & 1) << 1
+    | (popcnt(empty & UINT64_C(0x0F0F0F0F00000000)) & 1) << 2
+    | (popcnt(empty & UINT64_C(0xF0F0F0F000000000)) & 1) << 3;
+}
+
+// quadrant_parity bit of the quadrant containing pos
+inline unsigned char quadrant_bit(int pos) {
+  return 1 << (((pos >> 2) & 1) | ((pos >> 4) & 2));
+}
+
 struct Node {
   MobilityGenerator mg;
   char alpha;
   char beta;
   bool not_pass;
   bool passed_prev;
+  unsigned char parity; // quadrant_parity of the empties, fits in the padding
   Node() {}
   Node(const MobilityGenerator &mg, int alpha, int beta, bool passed_prev = false)
-    : mg(mg), alpha(alpha), beta(beta), not_pass(false), passed_prev(passed_prev) {}
+    : mg(mg), alpha(alpha), beta(beta), not_pass(false), passed_prev(passed_prev),
+      parity(quadrant_parity(mg.empty_pos())) {}
+  Node(const MobilityGenerator &mg, int alpha, int beta, unsigned char parity)
+    : mg(mg), alpha(alpha), beta(beta), not_pass(false), passed_prev(false), parity(parity) {}
   Node(const MobilityGenerator &mg)
     : Node(mg, -64, 64) {}
   Node(const Node &) = default;
   Node& operator=(const Node &) = default;
 };
 
-inline void swap(char &a, char &b) {
-  char tmp = a;
+template <typename T>
+inline void swap(T &a, T &b) {
+  T tmp = a;
   a = b;
   b = tmp;
 }
 
-inline void sort_by_key(char *first1, char *last1, char *first2) {
+template <typename Key>
+inline void sort_by_key(Key *first1, Key *last1, char *first2) {
   int n = last1 - first1;
   for (int i = 1; i < n; ++i) {
     int j = i;
@@ -97,35 +178,54 @@ inline void sort_by_key(char *first1, char *last1, char *first2) {
   }
 }
 
+// Upper search frame, 56 bytes without padding. The sorted_moves best
+// moves (fewest opponent replies first, or by ordering) are kept in order in
+// posary; any further legal moves stay in the rest bitmask and are tried
+// last, in square order.
 class UpperNode {
  public:
-  static constexpr int max_mobility_count = 46;
-  UpperNode(ull me, ull op, char alpha, char beta, bool pass = false)
-      : alpha(alpha), beta(beta), me(me), op(op), possize(0), index(0), prev_passed(pass) {
+  static constexpr int sorted_moves = 27;
+  UpperNode() {}
+  UpperNode(ull me, ull op, char alpha, char beta, bool pass = false, const Ordering *ordering = nullptr)
+      : me(me), op(op), rest(0), alpha(alpha), beta(beta), possize(0), index(0), prev_passed(pass) {
+    const bool evaluate = ordering && ordering->mode && 64 - stones_count(me, op) >= ordering->min_empties;
+    short cntary[64];
+    char allpos[64];
+    int count = 0;
     MobilityGenerator mg(me, op);
     while(!mg.completed()) {
       ull next_bit = mg.next_bit();
       int pos = popcnt(next_bit - 1);
       ull flip_bits = flip(me, op, pos);
       if (flip_bits) {
-        cntary[possize] = mobility_count(op ^ flip_bits, (me ^ flip_bits) | next_bit);
-        posary[possize++] = pos;
+        const ull next_me = op ^ flip_bits;
+        const ull next_op = (me ^ flip_bits) | next_bit;
+        cntary[count] = evaluate ? ordering_key(next_me, next_op, *ordering) : mobility_count(next_me, next_op);
+        allpos[count++] = pos;
       }
     }
-    sort_by_key(cntary, cntary + possize, posary);
+    sort_by_key(cntary, cntary + count, allpos);
+    for (int i = 0; i < count; ++i) {
+      if (i < sorted_moves) posary[possize++] = allpos[i];
+      else rest |= UINT64_C(1) << allpos[i];
+    }
   }
   UpperNode(const UpperNode &) = default;
   UpperNode(UpperNode &&) = default;
   UpperNode& operator=(const UpperNode &) = default;
   UpperNode& operator=(UpperNode &&) = default;
   bool completed() const {
-    return index == possize;
+    return index == possize && rest == 0;
   }
   int pop() {
-    return posary[index++];
+    if (index < possize) return posary[index++];
+    const int pos = popcnt((rest & -rest) - 1);
+    rest &= rest - 1;
+    return pos;
   }
+  // number of legal moves, tried or not
   int size() const {
-    return possize;
+    return possize + popcnt(rest);
   }
   ull me_pos() const {
     return me;
@@ -139,34 +239,36 @@ class UpperNode {
   int score() const {
     return final_score(me, op);
   }
-  UpperNode move(ull bits, ull pos_bit/*, Table table*/) const {
+  UpperNode move(ull bits, ull pos_bit, Table &table, const Ordering *ordering = nullptr) const {
     ull next_player = op ^ bits;
     ull next_opponent = (me ^ bits) | pos_bit;
-    //Entry entry = table.find(next_player, next_opponent);
-    //if (entry.enable) {
-    //  char next_alpha = max(-beta, entry.lower);
-    //  char next_beta = min(-alpha, entry.upper);
-    //  return UpperNode(next_player, next_opponent, next_alpha, next_beta);
-    //} else {
-      return UpperNode(next_player, next_opponent, -beta, -alpha);
-    //}
-  }
-  UpperNode pass(/*Table table*/) const {
-    //Entry entry = table.find(op, me);
-    //if (entry.enable) {
-    //  char next_alpha = max(-beta, entry.lower);
-    //  char next_beta = min(-alpha, entry.upper);
-    //  return UpperNode(op, me, next_alpha, next_beta, true);
-    //} else {
-      return UpperNode(op, me, -beta, -alpha, true);
-    //}
+    Entry entry = table.find(next_player, next_opponent);
+    if (entry.enable) {
+      char next_alpha = entry.lower > -beta ? entry.lower : -beta;
+      char next_beta = entry.upper < -alpha ? entry.upper : -alpha;
+      return UpperNode(next_player, next_opponent, next_alpha, next_beta, false, ordering);
+    } else {
+      return UpperNode(next_player, next_opponent, -beta, -alpha, false, ordering);
+    }
+  }
+  UpperNode pass(Table &table, const Ordering *ordering = nullptr) const {
+    Entry entry = table.find(op, me);
+    if (entry.enable) {
+      char next_alpha = entry.lower > -beta ? entry.lower : -beta;
+      char next_beta = entry.upper < -alpha ? entry.upper : -alpha;
+      return UpperNode(op, me, next_alpha, next_beta, true, ordering);
+    } else {
+      return UpperNode(op, me, -beta, -alpha, true, ordering);
+    }
   }
+ private:
+  ull me, op;
+  ull rest; // legal moves beyond posary
+ public:
   char alpha;
   char beta;
  private:
-  ull me,op;
-  char posary[max_mobility_count];
-  char cntary[max_mobility_count];
+  char posary[sorted_moves];
   unsigned char possize;
   unsigned char index;
   bool prev_passed;
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <iostream>
+#include "split.hpp"
+#include "board.hpp"
+
+namespace {
+
+struct SplitNode {
+  AlphaBetaProblem problem;
+  int value;      // best score found so far (fail-hard, starts at alpha)
+  ull nodes;      // nodes searched in this subtree
+  int parent;     // -1 for a root
+  int depth;      // plies left to expand
+  unsigned char parent_move; // the move from the parent, as AlphaBetaResult::move
+  unsigned char move;        // best child so far, first child until one raises value
+  std::vector<Board> children;
+  std::vector<unsigned char> child_moves;
+  std::size_t next_child;
+  int pending;
+};
+
+class SplitTree {
+ public:
+  SplitTree(AlphaBetaResult *results) : results(results) {}
+  void add_root(const AlphaBetaProblem &problem, std::size_t index, int depth) {
+    root_index.push_back(index);
+    start(create(problem, -1 - (int)(root_index.size() - 1), depth));
+  }
+  bool has_jobs() const {
+    return !jobs.empty();
+  }
+  void run_jobs(const std::vector<std::unique_ptr<Device>> &devices, const DispatchOptions &dispatch) {
+    std::vector<int> ids;
+    ids.swap(jobs);
+    std::vector<AlphaBetaProblem> batch;
+    batch.reserve(ids.size());
+    for (int id : ids) batch.push_back(nodes[id].problem);
+    std::vector<AlphaBetaResult> batch_results(ids.size());
+    solve_all(devices, batch.data(), batch_results.data(), batch.size(), dispatch);
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+      nodes[ids[i]].nodes = batch_results[i].nodes;
+      finish(ids[i], batch_results[i].score, batch_results[i].move);
+    }
+  }
+ private:
+  // parent < 0 encodes the root slot -1 - parent
+  int create(const AlphaBetaProblem &problem, int parent, int depth, unsigned char parent_move = 0) {
+    nodes.push_back((SplitNode){problem, problem.alpha, 1, parent, depth, parent_move, 0, {}, {}, 0, 0});
+    return nodes.size() - 1;
+  }
+  void start(int id) {
+    SplitNode &node = nodes[id];
+    if (node.depth == 0) {
+      jobs.push_back(id);
+      return;
+    }
+    const ull me = node.problem.me;
+    const ull op = node.problem.op;
+    UpperNode upper(me, op, node.problem.alpha, node.problem.beta);
+    while (!upper.completed()) {
+      const int pos = upper.pop();
+      const ull flip_bits = flip(me, op, pos);
+      node.children.emplace_back(op ^ flip_bits, (me ^ flip_bits) | (UINT64_C(1) << pos));
+      node.child_moves.push_back(1 + pos);
+    }
+    if (node.children.empty()) {
+      if (mobility(op, me) == 0) {
+        finish(id, final_score(me, op), 0);
+        return;
+      }
+      node.children.emplace_back(op, me); // pass
+      node.child_moves.push_back(0);
+    }
+    node.pending = 1;
+    spawn_child(id);
+  }
+  void spawn_child(int id) {
+    const SplitNode &node = nodes[id];
+    const Board &child = node.children[node.next_child];
+    const AlphaBetaProblem problem(child.me, child.op, -node.problem.beta, -node.value);
+    const int depth = node.depth - 1;
+    const unsigned char move = node.child_moves[node.next_child];
+    ++nodes[id].next_child;
+    start(create(problem, id, depth, move));
+  }
+  // move: the best move of node id, as AlphaBetaResult::move
+  void finish(int id, int score, unsigned char move) {
+    const int parent = nodes[id].parent;
+    if (parent < 0) {
+      results[root_index[-1 - parent]] = (AlphaBetaResult){nodes[id].nodes, score, false, 0, move};
+      return;
+    }
+    SplitNode &node = nodes[parent];
+    node.nodes += nodes[id].nodes;
+    if (-score > node.value || node.move == 0) node.move = nodes[id].parent_move;
+    node.value = std::max(node.value, -score);
+    const bool first = node.next_child == 1 && node.pending == 1;
+    if (--node.pending > 0) return;
+    if (first && node.value < node.problem.beta && node.next_child < node.children.size()) {
+      // the eldest brother is done, search the rest in parallel
+      node.pending = node.children.size() - node.next_child;
+      while (nodes[parent].next_child < nodes[parent].children.size()) spawn_child(parent);
+      return;
+    }
+    finish(parent, nodes[parent].value, nodes[parent].move);
+  }
+  AlphaBetaResult *results;
+  std::vector<std::size_t> root_index;
+  std::vector<SplitNode> nodes;
+  std::vector<int> jobs;
+};
+
+} // namespace
+
+void solve_split(const std::vector<std::unique_ptr<Device>> &devices,
+    const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count,
+    const DispatchOptions &dispatch, const SplitOptions &split) {
+  SplitTree tree(results);
+  std::size_t num_split = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    const int empties = 64 - stones_count(problems[i].me, problems[i].op);
+    const bool hard = split.depth > 0 && empties >= split.min_empties;
+    if (hard) ++num_split;
+    tree.add_root(problems[i], i, hard ? split.depth : 0);
+  }
+  int rounds = 0;
+  for (; tree.has_jobs(); ++rounds) {
+    tree.run_jobs(devices, dispatch);
+  }
+  std::cerr << "split " << num_split << " problems in " << rounds << " rounds" << std::endl;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "device.hpp"
+#include "dispatch.hpp"
+
+struct SplitOptions {
+  int depth;       // plies expanded on the host, 0 disables splitting
+  int min_empties; // only problems with at least this many empties are split
+};
+
+// Solve problems[0, count), expanding the top plies of hard problems into
+// sub-problems that are solved in parallel batches (young brothers wait:
+// the first child of a node is solved first, the rest together with the
+// window it established).
+void solve_split(const std::vector<std::unique_ptr<Device>> &devices,
+    const AlphaBetaProblem *problems, AlphaBetaResult *results, std::size_t count,
+    const DispatchOptions &dispatch, const SplitOptions &split);
@@ -0,0 +1,89 @@
+#include <unordered_map>
+#include "symmetry.hpp"
+
+namespace {
+
+ull flip_vertical(ull x) {
+  return __builtin_bswap64(x);
+}
+
+ull mirror_horizontal(ull x) {
+  x = ((x >> 1) & UINT64_C(0x5555555555555555)) | ((x & UINT64_C(0x5555555555555555)) << 1);
+  x = ((x >> 2) & UINT64_C(0x3333333333333333)) | ((x & UINT64_C(0x3333333333333333)) << 2);
+  x = ((x >> 4) & UINT64_C(0x0F0F0F0F0F0F0F0F)) | ((x & UINT64_C(0x0F0F0F0F0F0F0F0F)) << 4);
+  return x;
+}
+
+// reflection in the a1-h8 diagonal
+ull transpose(ull x) {
+  ull t;
+  t = UINT64_C(0x0F0F0F0F00000000) & (x ^ (x << 28));
+  x ^= t ^ (t >> 28);
+  t = UINT64_C(0x3333000033330000) & (x ^ (x << 14));
+  x ^= t ^ (t >> 14);
+  t = UINT64_C(0x5500550055005500) & (x ^ (x << 7));
+  x ^= t ^ (t >> 7);
+  return x;
+}
+
+struct ProblemKey {
+  ull me, op;
+  int alpha, beta;
+  bool operator==(const ProblemKey &other) const {
+    return me == other.me && op == other.op && alpha == other.alpha && beta == other.beta;
+  }
+};
+
+struct ProblemKeyHash {
+  std::size_t operator()(const ProblemKey &key) const {
+    ull h = key.me * UINT64_C(0x9E3779B97F4A7C15);
+    h ^= (key.op + (h << 6) + (h >> 2)) * UINT64_C(0xC2B2AE3D27D4EB4F);
+    h ^= (ull)(key.alpha + 128) << 8 | (ull)(key.beta + 128);
+    return h ^ (h >> 29);
+  }
+};
+
+} // namespace
+
+ull symmetric(ull x, int symmetry) {
+  if (symmetry & 1) x = flip_vertical(x);
+  if (symmetry & 2) x = mirror_horizontal(x);
+  if (symmetry & 4) x = transpose(x);
+  return x;
+}
+
+Board canonical(ull me, ull op) {
+  Board best(me, op);
+  for (int symmetry = 1; symmetry < 8; ++symmetry) {
+    const ull sme = symmetric(me, symmetry);
+    const ull sop = symmetric(op, symmetry);
+    if (sme < best.me || (sme == best.me && sop < best.op)) best = Board(sme, sop);
+  }
+  return best;
+}
+
+unsigned char map_move(const Board &from, const Board &to, unsigned char move) {
+  if (!move) return 0;
+  for (int symmetry = 0; symmetry < 8; ++symmetry) {
+    if (symmetric(from.me, symmetry) == to.me && symmetric(from.op, symmetry) == to.op) {
+      return 1 + __builtin_ctzll(symmetric(UINT64_C(1) << (move - 1), symmetry));
+    }
+  }
+  return 0;
+}
+
+void dedup_problems(const AlphaBetaProblem *problems, std::size_t count,
+    std::vector<AlphaBetaProblem> &unique, std::vector<std::size_t> &index) {
+  unique.clear();
+  index.resize(count);
+  std::unordered_map<ProblemKey, std::size_t, ProblemKeyHash> seen;
+  seen.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const AlphaBetaProblem &problem = problems[i];
+    const Board bd = canonical(problem.me, problem.op);
+    const ProblemKey key = {bd.me, bd.op, problem.alpha, problem.beta};
+    auto inserted = seen.insert(std::make_pair(key, unique.size()));
+    if (inserted.second) unique.push_back(problem);
+    index[i] = inserted.first->second;
+  }
+}
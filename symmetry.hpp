@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "types.hpp"
+#include "solver.hpp"
+
+// The 8 symmetries of the board (rotations and reflections) applied to a
+// bitboard; 0 is the identity.
+ull symmetric(ull x, int symmetry);
+
+// the least of the 8 symmetric variants of (me, op), ordered by (me, op)
+Board canonical(ull me, ull op);
+
+// AlphaBetaResult::move of position from as the move of position to, a
+// symmetric image of from; 0 if move is 0 or to is no image of from
+unsigned char map_move(const Board &from, const Board &to, unsigned char move);
+
+// Collects one problem per class of problems equal up to symmetry (same
+// window, canonical positions equal) into unique, keeping the first
+// occurrence as it is; problem i is unique[index[i]].
+void dedup_problems(const AlphaBetaProblem *problems, std::size_t count,
+    std::vector<AlphaBetaProblem> &unique, std::vector<std::size_t> &index);
@@ -0,0 +1,89 @@
+#include <cstdio>
+#include <random>
+#include <utility>
+#include "board.hpp"
+#include "symmetry.hpp"
+
+// Checks that canonical, symmetric and map_move agree: every move of a
+// position, mapped to each of its 8 images, leads to an image of the
+// position after the move and maps back to itself.
+//   make test
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+  if (!ok) {
+    std::printf("FAIL: %s\n", what);
+    ++failures;
+  }
+}
+
+// the position after the player to move plays pos, from the opponent's side
+Board after(const Board &bd, int pos) {
+  const ull flip_bits = flip(bd.me, bd.op, pos);
+  return Board(bd.op ^ flip_bits, bd.me ^ flip_bits ^ (UINT64_C(1) << pos));
+}
+
+// a position after plies random moves from the initial one
+Board random_position(std::mt19937_64 &rng, int plies) {
+  ull me = UINT64_C(0x0000000810000000), op = UINT64_C(0x0000001008000000);
+  for (int i = 0; i < plies; ++i) {
+    ull moves = mobility(me, op);
+    if (!moves) {
+      if (!mobility(op, me)) break;
+      std::swap(me, op);
+      continue;
+    }
+    for (int k = rng() % __builtin_popcountll(moves); k > 0; --k) moves &= moves - 1;
+    const Board next = after(Board(me, op), __builtin_ctzll(moves));
+    me = next.me;
+    op = next.op;
+  }
+  return Board(me, op);
+}
+
+void moves_through_symmetries(const Board &bd) {
+  const Board canon = canonical(bd.me, bd.op);
+  // on a symmetric position several symmetries map bd to the same image
+  // and its moves map back to one of their equivalents only
+  bool asymmetric = true;
+  for (int symmetry = 1; symmetry < 8; ++symmetry) {
+    asymmetric &= symmetric(bd.me, symmetry) != bd.me || symmetric(bd.op, symmetry) != bd.op;
+  }
+  for (int symmetry = 0; symmetry < 8; ++symmetry) {
+    const Board image(symmetric(bd.me, symmetry), symmetric(bd.op, symmetry));
+    const Board image_canon = canonical(image.me, image.op);
+    check(image_canon.me == canon.me && image_canon.op == canon.op, "images share the canonical position");
+    check(map_move(bd, image, 0) == 0, "no move maps to no move");
+    for (ull moves = mobility(bd.me, bd.op); moves; moves &= moves - 1) {
+      const int pos = __builtin_ctzll(moves);
+      const unsigned char move = 1 + pos;
+      const unsigned char mapped = map_move(bd, image, move);
+      check(mapped != 0 && ((mobility(image.me, image.op) >> (mapped - 1)) & 1), "mapped move is legal");
+      if (!mapped) continue;
+      const Board next = after(bd, pos), image_next = after(image, mapped - 1);
+      const Board canon_next = canonical(next.me, next.op), canon_image_next = canonical(image_next.me, image_next.op);
+      check(canon_next.me == canon_image_next.me && canon_next.op == canon_image_next.op,
+          "mapped move leads to an image of the position");
+      if (!asymmetric) continue;
+      check(map_move(image, bd, mapped) == move, "move maps back to itself");
+      const unsigned char to_canon = map_move(image, image_canon, mapped);
+      check(map_move(image_canon, bd, to_canon) == move, "move maps back through the canonical position");
+    }
+  }
+}
+
+} // namespace
+
+int main() {
+  std::mt19937_64 rng(1);
+  for (int i = 0; i < 1000; ++i) moves_through_symmetries(random_position(rng, rng() % 50));
+  // (me, op) swapped is no image
+  const Board bd = random_position(rng, 11);
+  check(map_move(bd, Board(bd.op, bd.me), 1 + __builtin_ctzll(mobility(bd.me, bd.op))) == 0,
+      "no move maps to a position that is no image");
+  std::printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
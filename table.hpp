@@ -0,0 +1,74 @@
+#pragma once
+#include "types.hpp"
+
+struct Entry {
+  bool enable;
+  char lower;
+  char upper;
+};
+
+// The key is stored xored with the data word, so an entry torn by a
+// concurrent write from another thread fails the key check instead of
+// returning bounds of a different position.
+struct TableEntry {
+  ull me_x;
+  ull op_x;
+  ull data;
+};
+
+class Table {
+ public:
+  Table() : hits(0), misses(0), entries(nullptr), mask(0) {}
+  // size must be a power of two, or 0 to disable the table
+  Table(TableEntry *entries, ull size)
+    : hits(0), misses(0), entries(size ? entries : nullptr), mask(size - 1) {}
+  bool enabled() const {
+    return entries != nullptr;
+  }
+  Entry find(ull me, ull op) {
+    if (!enabled()) return (Entry){false, -64, 64};
+    Entry entry = lookup(me, op);
+    if (entry.enable) ++hits;
+    else ++misses;
+    return entry;
+  }
+  // record the result of a search of (me, op) with window (alpha, beta)
+  void update(ull me, ull op, char alpha, char beta, char value) {
+    if (!enabled()) return;
+    Entry entry = lookup(me, op);
+    char lower = entry.enable ? entry.lower : -64;
+    char upper = entry.enable ? entry.upper : 64;
+    if (value <= alpha) {
+      if (value < upper) upper = value;
+    } else if (value >= beta) {
+      if (value > lower) lower = value;
+    } else {
+      lower = upper = value;
+    }
+    if (lower > upper) lower = upper = value;
+    const ull data = (ull)(unsigned char)lower | ((ull)(unsigned char)upper << 8) | (UINT64_C(1) << 16);
+    TableEntry &slot = entries[index(me, op)];
+    __atomic_store_n(&slot.data, data, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.me_x, me ^ data, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.op_x, op ^ data, __ATOMIC_RELAXED);
+  }
+  ull hits;
+  ull misses;
+ private:
+  ull index(ull me, ull op) const {
+    ull h = me * UINT64_C(0x9E3779B97F4A7C15) ^ op * UINT64_C(0xC2B2AE3D27D4EB4F);
+    return (h ^ (h >> 29)) & mask;
+  }
+  Entry lookup(ull me, ull op) const {
+    const TableEntry &slot = entries[index(me, op)];
+    const ull data = __atomic_load_n(&slot.data, __ATOMIC_RELAXED);
+    const ull me_x = __atomic_load_n(&slot.me_x, __ATOMIC_RELAXED);
+    const ull op_x = __atomic_load_n(&slot.op_x, __ATOMIC_RELAXED);
+    if (!((data >> 16) & 1) || (me_x ^ data) != me || (op_x ^ data) != op) {
+      return (Entry){false, -64, 64};
+    }
+    return (Entry){true, (char)(data & 0xFF), (char)((data >> 8) & 0xFF)};
+  }
+  TableEntry *entries;
+  ull mask;
+};
@@ -29,3 +29,166 @@ Board toBoard(const char * const str) {
   ull opponent = _mm_extract_epi64(res, 1);
   return Board(player, opponent);
 }
+
+void fromBoard(const Board &bd, char * const str) {
+  static const int weight[4] = {1, 3, 9, 32};
+  for (int i = 0; i < 16; ++i) {
+    int code = 33;
+    for (int j = 0; j < 4; ++j) {
+      const int pos = i*4 + j;
+      if ((bd.me >> pos) & 1) code += weight[j];
+      else if ((bd.op >> pos) & 1) code += 2*weight[j];
+    }
+    str[i] = code;
+  }
+}
+
+namespace {
+
+// The 256/512-bit versions run the toBoard steps above on two/four records
+// at once. Every instruction involved works within 128-bit lanes, and the
+// packed (player, opponent) pair of each lane is exactly the Board layout.
+
+__attribute__((target("avx2")))
+__m256i div9_epu8_avx2(__m256i x) {
+  __m256i hi = _mm256_and_si256(_mm256_maddubs_epi16(x, _mm256_set1_epi16(0x1d00)), _mm256_set1_epi16(0xFF00));
+  __m256i lo = _mm256_srli_epi16(_mm256_maddubs_epi16(x, _mm256_set1_epi16(0x001d)), 8);
+  return _mm256_or_si256(hi, lo);
+}
+
+__attribute__((target("avx2")))
+void to_board_avx2(const char *str, Board *boards, std::size_t count) {
+  const __m256i table1 = _mm256_broadcastsi128_si256(_mm_setr_epi8(0x0, 0x1, 0x0, 0x2, 0x3, 0x2, 0x0, 0x1, 0x0, 0,0,0,0,0,0,0));
+  const __m256i table2 = _mm256_broadcastsi128_si256(_mm_setr_epi8(0x0, 0x0, 0x1, 0x0, 0x0, 0x1, 0x2, 0x2, 0x3, 0,0,0,0,0,0,0));
+  std::size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m256i data = _mm256_loadu_si256((const __m256i*)(str + i*16));
+    data = _mm256_sub_epi8(data, _mm256_set1_epi8(33));
+    __m256i b = _mm256_and_si256(_mm256_srli_epi16(data, 2), _mm256_set1_epi8(0x08));
+    __m256i w = _mm256_and_si256(_mm256_srli_epi16(data, 3), _mm256_set1_epi8(0x08));
+    data = _mm256_and_si256(data, _mm256_set1_epi8(0x1F));
+    __m256i a2 = div9_epu8_avx2(data);
+    b = _mm256_or_si256(b, _mm256_and_si256(_mm256_slli_epi16(a2, 2), _mm256_set1_epi8(0x04)));
+    w = _mm256_or_si256(w, _mm256_and_si256(_mm256_slli_epi16(a2, 1), _mm256_set1_epi8(0x04)));
+    data = _mm256_sub_epi8(data, _mm256_mullo_epi16(a2, _mm256_set1_epi16(9)));
+    b = _mm256_or_si256(b, _mm256_shuffle_epi8(table1, data));
+    w = _mm256_or_si256(w, _mm256_shuffle_epi8(table2, data));
+    b = _mm256_maddubs_epi16(b, _mm256_set1_epi16(0x1001));
+    w = _mm256_maddubs_epi16(w, _mm256_set1_epi16(0x1001));
+    _mm256_storeu_si256((__m256i*)(boards + i), _mm256_packus_epi16(b, w));
+  }
+  for (; i < count; ++i) boards[i] = toBoard(str + i*16);
+}
+
+__attribute__((target("avx512bw")))
+__m512i div9_epu8_avx512(__m512i x) {
+  __m512i hi = _mm512_and_si512(_mm512_maddubs_epi16(x, _mm512_set1_epi16(0x1d00)), _mm512_set1_epi16(0xFF00));
+  __m512i lo = _mm512_srli_epi16(_mm512_maddubs_epi16(x, _mm512_set1_epi16(0x001d)), 8);
+  return _mm512_or_si512(hi, lo);
+}
+
+__attribute__((target("avx512bw")))
+void to_board_avx512(const char *str, Board *boards, std::size_t count) {
+  const __m512i table1 = _mm512_broadcast_i32x4(_mm_setr_epi8(0x0, 0x1, 0x0, 0x2, 0x3, 0x2, 0x0, 0x1, 0x0, 0,0,0,0,0,0,0));
+  const __m512i table2 = _mm512_broadcast_i32x4(_mm_setr_epi8(0x0, 0x0, 0x1, 0x0, 0x0, 0x1, 0x2, 0x2, 0x3, 0,0,0,0,0,0,0));
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m512i data = _mm512_loadu_si512(str + i*16);
+    data = _mm512_sub_epi8(data, _mm512_set1_epi8(33));
+    __m512i b = _mm512_and_si512(_mm512_srli_epi16(data, 2), _mm512_set1_epi8(0x08));
+    __m512i w = _mm512_and_si512(_mm512_srli_epi16(data, 3), _mm512_set1_epi8(0x08));
+    data = _mm512_and_si512(data, _mm512_set1_epi8(0x1F));
+    __m512i a2 = div9_epu8_avx512(data);
+    b = _mm512_or_si512(b, _mm512_and_si512(_mm512_slli_epi16(a2, 2), _mm512_set1_epi8(0x04)));
+    w = _mm512_or_si512(w, _mm512_and_si512(_mm512_slli_epi16(a2, 1), _mm512_set1_epi8(0x04)));
+    data = _mm512_sub_epi8(data, _mm512_mullo_epi16(a2, _mm512_set1_epi16(9)));
+    b = _mm512_or_si512(b, _mm512_shuffle_epi8(table1, data));
+    w = _mm512_or_si512(w, _mm512_shuffle_epi8(table2, data));
+    b = _mm512_maddubs_epi16(b, _mm512_set1_epi16(0x1001));
+    w = _mm512_maddubs_epi16(w, _mm512_set1_epi16(0x1001));
+    _mm512_storeu_si512(boards + i, _mm512_packus_epi16(b, w));
+  }
+  to_board_avx2(str + i*16, boards + i, count - i);
+}
+
+void to_board_sse(const char *str, Board *boards, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) boards[i] = toBoard(str + i*16);
+}
+
+// Encoding: each character covers one nibble of me and of op, and its code
+// is 33 + weight(me nibble) + 2 * weight(op nibble), looked up with pshufb.
+#define WEIGHT_TABLE(k) \
+  0, 1*k, 3*k, 4*k, 9*k, 10*k, 12*k, 13*k, \
+  32*k, 33*k, 35*k, 36*k, 41*k, 42*k, 44*k, 45*k
+
+__attribute__((target("avx2")))
+void from_board_avx2(const Board *boards, char *str, std::size_t count) {
+  const __m256i me_weight = _mm256_broadcastsi128_si256(_mm_setr_epi8(WEIGHT_TABLE(1)));
+  const __m256i op_weight = _mm256_broadcastsi128_si256(_mm_setr_epi8(WEIGHT_TABLE(2)));
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  std::size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    const __m256i data = _mm256_loadu_si256((const __m256i*)(boards + i));
+    const __m256i lo = _mm256_and_si256(data, nibble);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(data, 4), nibble);
+    const __m256i me = _mm256_unpacklo_epi8(lo, hi);
+    const __m256i op = _mm256_unpackhi_epi8(lo, hi);
+    __m256i code = _mm256_add_epi8(_mm256_shuffle_epi8(me_weight, me), _mm256_shuffle_epi8(op_weight, op));
+    code = _mm256_add_epi8(code, _mm256_set1_epi8(33));
+    _mm256_storeu_si256((__m256i*)(str + i*16), code);
+  }
+  for (; i < count; ++i) fromBoard(boards[i], str + i*16);
+}
+
+__attribute__((target("avx512bw")))
+void from_board_avx512(const Board *boards, char *str, std::size_t count) {
+  const __m512i me_weight = _mm512_broadcast_i32x4(_mm_setr_epi8(WEIGHT_TABLE(1)));
+  const __m512i op_weight = _mm512_broadcast_i32x4(_mm_setr_epi8(WEIGHT_TABLE(2)));
+  const __m512i nibble = _mm512_set1_epi8(0x0F);
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m512i data = _mm512_loadu_si512(boards + i);
+    const __m512i lo = _mm512_and_si512(data, nibble);
+    const __m512i hi = _mm512_and_si512(_mm512_srli_epi16(data, 4), nibble);
+    const __m512i me = _mm512_unpacklo_epi8(lo, hi);
+    const __m512i op = _mm512_unpackhi_epi8(lo, hi);
+    __m512i code = _mm512_add_epi8(_mm512_shuffle_epi8(me_weight, me), _mm512_shuffle_epi8(op_weight, op));
+    code = _mm512_add_epi8(code, _mm512_set1_epi8(33));
+    _mm512_storeu_si512(str + i*16, code);
+  }
+  from_board_avx2(boards + i, str + i*16, count - i);
+}
+
+#undef WEIGHT_TABLE
+
+void from_board_scalar(const Board *boards, char *str, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) fromBoard(boards[i], str + i*16);
+}
+
+const BoardCodec &codec() {
+  static const BoardCodec selected = board_codecs().front();
+  return selected;
+}
+
+} // namespace
+
+void toBoardBatch(const char * const str, Board * const boards, const std::size_t count) {
+  codec().decode(str, boards, count);
+}
+
+void fromBoardBatch(const Board * const boards, char * const str, const std::size_t count) {
+  codec().encode(boards, str, count);
+}
+
+std::vector<BoardCodec> board_codecs() {
+  __builtin_cpu_init();
+  std::vector<BoardCodec> codecs;
+  if (__builtin_cpu_supports("avx512bw")) codecs.push_back({"avx512", to_board_avx512, from_board_avx512});
+  if (__builtin_cpu_supports("avx2")) codecs.push_back({"avx2", to_board_avx2, from_board_avx2});
+  codecs.push_back({"sse", to_board_sse, from_board_scalar});
+  return codecs;
+}
+
+const char *board_codec_name() {
+  return codec().name;
+}
@@ -1,5 +1,29 @@
 #pragma once
+#include <cstddef>
 #include <utility>
+#include <vector>
 #include "types.hpp"
 
 Board toBoard(const char * const str);
+// writes the 16 base-81 characters of bd to str (not null-terminated)
+void fromBoard(const Board &bd, char * const str);
+
+// Batch versions over count records packed 16 characters apart. They use
+// the widest of AVX-512BW, AVX2 and the single-record code above that the
+// running CPU supports.
+void toBoardBatch(const char * const str, Board * const boards, const std::size_t count);
+void fromBoardBatch(const Board * const boards, char * const str, const std::size_t count);
+const char *board_codec_name();
+
+using ToBoardBatch = void (*)(const char *, Board *, std::size_t);
+using FromBoardBatch = void (*)(const Board *, char *, std::size_t);
+
+struct BoardCodec {
+  const char *name;
+  ToBoardBatch decode;
+  FromBoardBatch encode;
+};
+
+// the batch codecs the running CPU supports, widest first; the batch
+// versions above use the first one
+std::vector<BoardCodec> board_codecs();
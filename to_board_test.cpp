@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "to_board.hpp"
+
+// Checks every batch codec the running CPU supports against toBoard and
+// fromBoard, over counts that are not multiples of the vector widths.
+//   make test
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *codec, const char *what, std::size_t count) {
+  if (!ok) {
+    std::printf("FAIL: %s %s, %zu records\n", codec, what, count);
+    ++failures;
+  }
+}
+
+std::vector<Board> random_boards(std::mt19937_64 &rng, std::size_t count) {
+  std::vector<Board> boards;
+  for (std::size_t i = 0; i < count; ++i) {
+    const ull me = rng(), op = rng() & ~me;
+    boards.emplace_back(me, op);
+  }
+  return boards;
+}
+
+void round_trip(const BoardCodec &codec, const std::vector<Board> &boards) {
+  const std::size_t count = boards.size();
+  std::vector<char> expected(count * 16), str(count * 16);
+  for (std::size_t i = 0; i < count; ++i) fromBoard(boards[i], expected.data() + i*16);
+  codec.encode(boards.data(), str.data(), count);
+  check(str == expected, codec.name, "encode", count);
+  std::vector<Board> decoded(count, Board(0, 0));
+  codec.decode(expected.data(), decoded.data(), count);
+  bool same = true;
+  for (std::size_t i = 0; i < count; ++i) {
+    const Board bd = toBoard(expected.data() + i*16);
+    same &= decoded[i].me == bd.me && decoded[i].op == bd.op;
+    same &= bd.me == boards[i].me && bd.op == boards[i].op;
+  }
+  check(same, codec.name, "decode", count);
+}
+
+} // namespace
+
+int main() {
+  std::mt19937_64 rng(1);
+  for (const BoardCodec &codec : board_codecs()) {
+    for (std::size_t count = 0; count <= 19; ++count) round_trip(codec, random_boards(rng, count));
+    round_trip(codec, random_boards(rng, 1003));
+    std::printf("%s: checked\n", codec.name);
+  }
+  std::printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
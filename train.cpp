@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "problem_file.hpp"
+#include "symmetry.hpp"
+#include "pattern.hpp"
+
+// Fits the pattern weights of pattern.hpp to solved positions by stochastic
+// gradient descent on the squared error, over all 8 symmetric images of
+// every position whose score is exact.
+//   train [--epochs=N] [--rate=R] PROBLEMS RESULTS.bin WEIGHTS
+
+namespace {
+
+struct Sample {
+  int index[pattern_instances + 1];
+  float target; // in 1/pattern_scale discs
+};
+
+bool starts_with(const std::string &str, const std::string &prefix) {
+  return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+Sample make_sample(ull me, ull op, int score) {
+  Sample sample;
+  for (int k = 0; k < pattern_instances; ++k) sample.index[k] = pattern_index(me, op, k);
+  sample.index[pattern_instances] = mobility_offset + mobility_count(me, op);
+  sample.target = score * pattern_scale;
+  return sample;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int epochs = 30;
+  float rate = 0.01f;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (starts_with(arg, "--epochs=")) {
+      epochs = std::max(1, std::stoi(arg.substr(9)));
+    } else if (starts_with(arg, "--rate=")) {
+      rate = std::stof(arg.substr(7));
+    } else {
+      args.push_back(arg);
+    }
+  }
+  if (args.size() != 3) {
+    std::cerr << "usage: " << argv[0] << " [--epochs=N] [--rate=R] PROBLEMS RESULTS WEIGHTS" << std::endl;
+    return 1;
+  }
+  ProblemSet problems;
+  if (!problems.load(args[0])) return 1;
+  ResultSet results;
+  if (!results.load(args[1])) return 1;
+  if (results.size() != problems.size()) {
+    std::cerr << "problem count " << problems.size() << " != result count " << results.size() << std::endl;
+    return 1;
+  }
+  std::vector<Sample> samples;
+  for (std::size_t i = 0; i < problems.size(); ++i) {
+    const AlphaBetaProblem &problem = problems.data()[i];
+    const int score = results.data()[i].score;
+    if (score <= problem.alpha || score >= problem.beta) continue; // only a bound
+    for (int s = 0; s < 8; ++s) {
+      samples.push_back(make_sample(symmetric(problem.me, s), symmetric(problem.op, s), score));
+    }
+  }
+  if (samples.empty()) {
+    std::cerr << "no exact scores in " << args[1] << std::endl;
+    return 1;
+  }
+  std::cerr << "samples: " << samples.size() << std::endl;
+
+  std::vector<float> weights(pattern_weight_count, 0.0f);
+  std::mt19937_64 rng(1);
+  for (int epoch = 0; epoch < epochs; ++epoch) {
+    std::shuffle(samples.begin(), samples.end(), rng);
+    double squared = 0;
+    for (const Sample &sample : samples) {
+      float predicted = 0;
+      for (int index : sample.index) predicted += weights[index];
+      const float error = sample.target - predicted;
+      squared += (double)error * error;
+      for (int index : sample.index) weights[index] += rate * error;
+    }
+    std::fprintf(stderr, "epoch %d: rms %.3f discs\n", epoch + 1,
+        std::sqrt(squared / samples.size()) / pattern_scale);
+  }
+  std::vector<short> rounded(pattern_weight_count);
+  for (int i = 0; i < pattern_weight_count; ++i) {
+    rounded[i] = (short)std::max(-32767.0f, std::min(32767.0f, std::round(weights[i])));
+  }
+  return write_pattern_weights(args[2], rounded) ? 0 : 1;
+}
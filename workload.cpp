@@ -0,0 +1,70 @@
+#include <algorithm>
+#include "workload.hpp"
+#include "board.hpp"
+
+namespace {
+
+// Values are derived from the engine output alone: mt19937_64 is fully
+// specified, the standard distributions are not, and would give other
+// positions for the same seed with another standard library.
+
+// uniform in [0, n), by rejecting the top partial range of engine outputs
+ull uniform_below(std::mt19937_64 &rng, ull n) {
+  const ull limit = UINT64_MAX - UINT64_MAX % n;
+  ull x;
+  do {
+    x = rng();
+  } while (x >= limit);
+  return x % n;
+}
+
+// index of a legal move in moves, as a bit count from the lowest bit
+int choose_move(std::mt19937_64 &rng, ull me, ull op, ull moves, Playout playout) {
+  const int count = popcnt(moves);
+  if (playout == Playout::uniform) return uniform_below(rng, count);
+  // weight 1 / (1 + the opponent's mobility), in fixed point
+  ull weights[64];
+  ull total = 0;
+  int index = 0;
+  for (ull bits = moves; bits; bits &= bits - 1) {
+    const int pos = __builtin_ctzll(bits);
+    const ull flip_bits = flip(me, op, pos);
+    weights[index] = (UINT64_C(1) << 20) / (1 + mobility_count(op ^ flip_bits, (me ^ flip_bits) | (UINT64_C(1) << pos)));
+    total += weights[index++];
+  }
+  ull r = uniform_below(rng, total);
+  for (index = 0; r >= weights[index]; ++index) r -= weights[index];
+  return index;
+}
+
+} // namespace
+
+Board random_position(std::mt19937_64 &rng, int empties, Playout playout) {
+  while (true) {
+    ull me = UINT64_C(0x0000000810000000), op = UINT64_C(0x0000001008000000);
+    while (64 - stones_count(me, op) > empties) {
+      ull moves = mobility(me, op);
+      if (!moves) {
+        if (!mobility(op, me)) break;
+        std::swap(me, op);
+        continue;
+      }
+      for (int skip = choose_move(rng, me, op, moves, playout); skip > 0; --skip) moves &= moves - 1;
+      const int pos = __builtin_ctzll(moves);
+      const ull flip_bits = flip(me, op, pos);
+      const ull next_me = op ^ flip_bits;
+      op = (me ^ flip_bits) | (UINT64_C(1) << pos);
+      me = next_me;
+    }
+    if (64 - stones_count(me, op) == empties && mobility(me, op)) return Board(me, op);
+  }
+}
+
+std::vector<Board> random_positions(ull seed, std::size_t count,
+    int min_empties, int max_empties, Playout playout) {
+  std::mt19937_64 rng(seed);
+  std::vector<Board> res;
+  res.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) res.push_back(random_position(rng, min_empties + (int)uniform_below(rng, max_empties - min_empties + 1), playout));
+  return res;
+}
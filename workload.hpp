@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <random>
+#include <vector>
+#include "types.hpp"
+
+enum class Playout {
+  uniform,  // every legal move equally likely
+  mobility, // moves leaving the opponent fewer moves are preferred
+};
+
+// A position with the given number of empties reached by seeded random play
+// from the initial position. Games that end early are replayed, and the side
+// to move always has a legal move (no pass or finished positions).
+Board random_position(std::mt19937_64 &rng, int empties, Playout playout = Playout::uniform);
+
+// count positions with empties drawn uniformly from [min_empties, max_empties]
+std::vector<Board> random_positions(ull seed, std::size_t count,
+    int min_empties, int max_empties, Playout playout = Playout::uniform);